@@ -0,0 +1,234 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lv2/urid/urid.h>
+#include <lvtk/ext/log.hpp>
+
+namespace lvtk {
+
+/** A @ref LogSink which keeps records in binary form.
+
+    Each format string and type URI is stored once, records only hold
+    a small format index, the type and the encoded arguments.  Nothing is formatted until
+    the log is read back, which makes this much smaller and cheaper than
+    a text log.
+
+    Arguments are stored in the writer's byte order; `read` rejects logs
+    written on a machine with a different one.
+
+    @code
+        lvtk::BinaryLog sink (&unmap);
+        log.flush (sink);
+        sink.write_file ("session.lvtklog");
+
+        // later, anywhere
+        lvtk::BinaryLog::read (data, size, [] (const lvtk::BinaryLog::Entry& e) {
+            std::cout << e.type_uri << ": " << e.text();
+        });
+    @endcode
+
+    @headerfile lvtk/binary_log.hpp
+    @ingroup log
+ */
+class BinaryLog final : public LogSink {
+public:
+    /** A record read back from a log */
+    struct Entry {
+        uint32_t type;         /**< Type URID in the writing session */
+        const char* type_uri;  /**< Type URI, or empty if it wasn't known */
+        uint32_t id;           /**< Format id, see @ref LogFormat::id */
+        const char* format;    /**< The format string */
+        const void* args;      /**< Encoded arguments */
+        uint32_t size;         /**< Size of `args` */
+
+        /** Format the message */
+        std::string text() const { return format_log (format, args, size); }
+    };
+
+    /** Create an empty log.
+        @param unmap Optional unmap used to store type URIs
+     */
+    explicit BinaryLog (const LV2_URID_Unmap* unmap = nullptr) : unmap (unmap) { clear(); }
+
+    void record (uint32_t type, const char* format, const void* args, uint32_t size) override {
+        auto known = ids.find (format);
+        if (known == ids.end()) {
+            known = ids.emplace (format, (uint32_t) ids.size()).first;
+            put_tag ('F');
+            put_varint (known->second);
+            put (detail::log_format_id (format));
+            put_string (format);
+        }
+
+        if (unmap != nullptr && types.find (type) == types.end()) {
+            types.emplace (type, true);
+            const char* uri = unmap->unmap (unmap->handle, type);
+            put_tag ('T');
+            put_varint (type);
+            put_string (uri != nullptr ? uri : "");
+        }
+
+        put_tag ('R');
+        put_varint (known->second);
+        put_varint (type);
+        put_varint (size);
+        const auto bytes = static_cast<const uint8_t*> (args);
+        buffer.insert (buffer.end(), bytes, bytes + size);
+        ++count;
+    }
+
+    /** @returns the log data */
+    const uint8_t* data() const noexcept { return buffer.data(); }
+    /** @returns the log size in bytes */
+    size_t size() const noexcept { return buffer.size(); }
+    /** @returns the number of records */
+    size_t records() const noexcept { return count; }
+
+    /** Remove all records */
+    void clear() {
+        buffer.assign (magic, magic + sizeof (magic));
+        buffer.push_back (byte_order());
+        ids.clear();
+        types.clear();
+        count = 0;
+    }
+
+    /** Write the log to a file.
+        @returns true on success
+     */
+    bool write_file (const std::string& path) const {
+        auto file = std::fopen (path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+        const bool ok = std::fwrite (buffer.data(), 1, buffer.size(), file) == buffer.size();
+        return std::fclose (file) == 0 && ok;
+    }
+
+    /** Read records from log data.
+
+        @param data     Log data, e.g. a mapped log file
+        @param size     Size of data in bytes
+        @param callback Called for each record in order
+        @returns false if the data is corrupt, records before the
+                 corruption are still passed to the callback
+     */
+    static bool read (const void* data, size_t size, const std::function<void (const Entry&)>& callback) {
+        auto p = static_cast<const uint8_t*> (data);
+        const auto end = p + size;
+        if (size < sizeof (magic) + 1 || std::memcmp (p, magic, sizeof (magic)) != 0
+            || p[sizeof (magic)] != byte_order())
+            return false;
+        p += sizeof (magic) + 1;
+
+        struct Format {
+            uint32_t id;
+            std::string text;
+        };
+        std::unordered_map<uint32_t, Format> formats;
+        std::unordered_map<uint32_t, std::string> uris;
+        auto get_varint = [&p, end] (uint32_t& value) {
+            value = 0;
+            for (unsigned shift = 0; shift < 32 && p < end; shift += 7) {
+                const uint8_t b = *p++;
+                value |= (uint32_t) (b & 0x7f) << shift;
+                if ((b & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        };
+        auto get_string = [&] (std::string& str) {
+            uint32_t length = 0;
+            if (! get_varint (length) || (size_t) (end - p) < length)
+                return false;
+            str.assign ((const char*) p, length);
+            p += length;
+            return true;
+        };
+
+        while (p < end) {
+            const uint8_t tag = *p++;
+            uint32_t key = 0;
+            if (! get_varint (key))
+                return false;
+
+            if (tag == 'F') {
+                auto& format = formats[key];
+                if ((size_t) (end - p) < sizeof (uint32_t))
+                    return false;
+                std::memcpy (&format.id, p, sizeof (uint32_t));
+                p += sizeof (uint32_t);
+                if (! get_string (format.text))
+                    return false;
+            } else if (tag == 'T') {
+                if (! get_string (uris[key]))
+                    return false;
+            } else if (tag == 'R') {
+                Entry entry;
+                if (! get_varint (entry.type) || ! get_varint (entry.size) || (size_t) (end - p) < entry.size)
+                    return false;
+                const auto format = formats.find (key);
+                if (format == formats.end())
+                    return false;
+                const auto uri = uris.find (entry.type);
+                entry.type_uri = uri != uris.end() ? uri->second.c_str() : "";
+                entry.id = format->second.id;
+                entry.format = format->second.text.c_str();
+                entry.args = p;
+                p += entry.size;
+                callback (entry);
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr uint8_t magic[8] = { 'l', 'v', 't', 'k', 'l', 'o', 'g', '1' };
+    const LV2_URID_Unmap* unmap = nullptr;
+    std::vector<uint8_t> buffer;
+    std::unordered_map<const char*, uint32_t> ids;
+    std::unordered_map<uint32_t, bool> types;
+    size_t count = 0;
+
+    static uint8_t byte_order() noexcept {
+        const uint16_t one = 1;
+        uint8_t first;
+        std::memcpy (&first, &one, 1);
+        return first == 1 ? 'l' : 'b';
+    }
+
+    void put_tag (char tag) { buffer.push_back ((uint8_t) tag); }
+
+    void put (uint32_t value) {
+        const auto bytes = reinterpret_cast<const uint8_t*> (&value);
+        buffer.insert (buffer.end(), bytes, bytes + sizeof (value));
+    }
+
+    void put_varint (uint32_t value) {
+        while (value >= 0x80) {
+            buffer.push_back ((uint8_t) (value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back ((uint8_t) value);
+    }
+
+    void put_string (const char* str) {
+        const auto length = (uint32_t) std::strlen (str);
+        put_varint (length);
+        buffer.insert (buffer.end(), str, str + length);
+    }
+};
+
+} // namespace lvtk
@@ -10,15 +10,15 @@
 
     class MyManifest : public lvtk::DynManifest {
     public:
-        bool get_subjects (std::stringstream& lines) override {
-            lines << "@prefix doap:  <http://usefulinc.com/ns/doap#> . " << std::endl
-                    << "@prefix lv2:   <http://lv2plug.in/ns/lv2core#> . " << std::endl
-                    << "<http://myplugin.org> a lv2:Plugin ;" << std::endl;
+        bool write_subjects (lvtk::ManifestWriter& out) override {
+            out << "@prefix doap:  <http://usefulinc.com/ns/doap#> .\n"
+                << "@prefix lv2:   <http://lv2plug.in/ns/lv2core#> .\n"
+                << "<http://myplugin.org> a lv2:Plugin .\n";
             return true;
         }
 
-        bool get_data (std::stringstream& lines, const std::string& uri) override {
-            lines << "doap:name \"My Plugin\" ;" << std::endl;
+        bool write_data (lvtk::ManifestWriter& out, const std::string& uri) override {
+            out << "<" << uri << "> doap:name \"My Plugin\" .\n";
             return true;
         }
     };
@@ -32,14 +32,111 @@
 #pragma once
 
 #include <cstdio>
+#include <cstring>
 #include <lv2/dynmanifest/dynmanifest.h>
+#include <ostream>
 #include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <lvtk/metadata.hpp>
+
+/** Size of a ManifestWriter's output buffer */
+#ifndef LVTK_MANIFEST_BUFFER_SIZE
+    #define LVTK_MANIFEST_BUFFER_SIZE 16384
+#endif
 
 namespace lvtk {
+
+/** Buffered Turtle output for a @ref DynManifest
+
+    Writes to the host's FILE in large blocks, or appends to a string.
+    @ingroup dynmanifest
+    @headerfile lvtk/dynmanifest.hpp
+ */
+class ManifestWriter final {
+public:
+    /** Write to a file */
+    explicit ManifestWriter (FILE* file) : file (file) {}
+    /** Append to a string */
+    explicit ManifestWriter (std::string& text) : text (&text) {}
+    ~ManifestWriter() { flush(); }
+
+    /** Write bytes */
+    ManifestWriter& write (const char* data, size_t size) {
+        if (text != nullptr) {
+            text->append (data, size);
+            return *this;
+        }
+        if (used + size > sizeof (buffer)) {
+            flush();
+            if (size >= sizeof (buffer)) {
+                failed |= size != std::fwrite (data, 1, size, file);
+                return *this;
+            }
+        }
+        std::memcpy (buffer + used, data, size);
+        used += size;
+        return *this;
+    }
+
+    ManifestWriter& operator<< (const char* str) { return write (str, std::strlen (str)); }
+    ManifestWriter& operator<< (const std::string& str) { return write (str.data(), str.size()); }
+    ManifestWriter& operator<< (char c) { return write (&c, 1); }
+
+    /** Write a number */
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    ManifestWriter& operator<< (T value) {
+        char str[32];
+        int length;
+        if constexpr (std::is_floating_point<T>::value)
+            length = std::snprintf (str, sizeof (str), "%.9g", (double) value);
+        else if constexpr (std::is_signed<T>::value)
+            length = std::snprintf (str, sizeof (str), "%lld", (long long) value);
+        else
+            length = std::snprintf (str, sizeof (str), "%llu", (unsigned long long) value);
+        return write (str, (size_t) length);
+    }
+
+    /** Accepts std::endl, writing a newline */
+    ManifestWriter& operator<< (std::ostream& (*) (std::ostream&)) { return write ("\n", 1); }
+
+    /** Write buffered output to the file
+        @returns false if any write failed
+     */
+    bool flush() {
+        if (file != nullptr && used > 0) {
+            failed |= used != std::fwrite (buffer, 1, used, file);
+            used = 0;
+        }
+        return ! failed;
+    }
+
+private:
+    FILE* file = nullptr;
+    std::string* text = nullptr;
+    size_t used = 0;
+    bool failed = false;
+    char buffer[LVTK_MANIFEST_BUFFER_SIZE];
+
+    ManifestWriter (const ManifestWriter&) = delete;
+    ManifestWriter& operator= (const ManifestWriter&) = delete;
+};
+
 /** Dynamic Manifest helper class
     
-    To create a dynamic manifest, subclass this an implement it's pure virtual
-    methods. Then implement lvtk_create_dyn_manifest().
+    To create a dynamic manifest, subclass this and implement `write_subjects`
+    and `write_data`. Then implement lvtk_create_dyn_manifest().
+
+    Data for each URI is rendered once and reused for repeated requests
+    while the manifest is open.  Call `set_data_cached (false)` if data
+    can change between requests.
+
+    The older `get_subjects` and `get_data` stream functions are still used
+    if the writer functions aren't overridden.
+
     @ingroup dynmanifest
     @headerfile lvtk/dynmanifest.hpp
  */
@@ -48,18 +145,135 @@ public:
     DynManifest() = default;
     virtual ~DynManifest() = default;
 
+    /** Write the subjects
+        @param out  Output for the Turtle
+        @return false if problems getting subjects
+     */
+    virtual bool write_subjects (ManifestWriter& out) {
+        std::stringstream lines;
+        if (! get_subjects (lines))
+            return false;
+        out << lines.str();
+        return true;
+    }
+
+    /** Write the data
+        @param out  Output for the Turtle
+        @param uri  The subject URI to get data for
+        @return false if problems getting data
+     */
+    virtual bool write_data (ManifestWriter& out, const std::string& uri) {
+        std::stringstream lines;
+        if (! get_data (lines, uri))
+            return false;
+        out << lines.str();
+        return true;
+    }
+
     /** Get the subjects
         @param lines    Add each line to this stream
         @return false if problems getting subjects
+        @deprecated Override write_subjects
      */
-    virtual bool get_subjects (std::stringstream& lines) = 0;
+    virtual bool get_subjects (std::stringstream& lines) { return false; }
 
     /** Get the data
         @param uri      The subject URI to get data for
         @param lines    Add each line to this stream
         @return false if problems getting data
+        @deprecated Override write_data
      */
-    virtual bool get_data (std::stringstream& lines, const std::string& uri) = 0;
+    virtual bool get_data (std::stringstream& lines, const std::string& uri) { return false; }
+
+    /** Enable or disable reuse of rendered data. Enabled by default */
+    void set_data_cached (bool cached) {
+        cache_data = cached;
+        if (! cached)
+            cache.clear();
+    }
+
+    /** Discard rendered data */
+    void clear_data_cache() { cache.clear(); }
+
+    /** @private */
+    int write_subjects_file (FILE* fp) {
+        ManifestWriter out (fp);
+        if (! write_subjects (out))
+            return 1;
+        return out.flush() ? 0 : 2;
+    }
+
+    /** @private */
+    int write_data_file (FILE* fp, const std::string& uri) {
+        if (! cache_data) {
+            ManifestWriter out (fp);
+            if (! write_data (out, uri))
+                return 1;
+            return out.flush() ? 0 : 2;
+        }
+
+        auto cached = cache.find (uri);
+        if (cached == cache.end()) {
+            std::string text;
+            {
+                ManifestWriter out (text);
+                if (! write_data (out, uri))
+                    return 1;
+            }
+            cached = cache.emplace (uri, std::move (text)).first;
+        }
+
+        const auto& text = cached->second;
+        return text.size() == std::fwrite (text.data(), 1, text.size(), fp) ? 0 : 2;
+    }
+
+private:
+    bool cache_data = true;
+    std::unordered_map<std::string, std::string> cache;
+};
+
+/** A @ref DynManifest which serves @ref PluginInfo descriptions
+
+    Serves the same Turtle a build step writes with @ref write_turtle,
+    so a plugin's ports are described by its C++ declarations only.
+
+    @code
+    void* lvtk_create_dyn_manifest() {
+        auto manifest = new lvtk::PluginManifest();
+        manifest->add (my_plugin_info);
+        return manifest;
+    }
+    @endcode
+
+    @ingroup dynmanifest
+    @headerfile lvtk/dynmanifest.hpp
+ */
+class PluginManifest : public DynManifest {
+public:
+    PluginManifest() = default;
+
+    /** Add a plugin. The info must outlive the manifest */
+    void add (const PluginInfo& info) { plugins.push_back (&info); }
+
+    bool write_subjects (ManifestWriter& out) override {
+        out << "@prefix lv2: <http://lv2plug.in/ns/lv2core#> .\n\n";
+        for (const auto* info : plugins)
+            out << "<" << info->uri << "> a lv2:Plugin .\n";
+        return true;
+    }
+
+    bool write_data (ManifestWriter& out, const std::string& uri) override {
+        for (const auto* info : plugins) {
+            if (uri == info->uri) {
+                write_turtle (out, *info);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::vector<const PluginInfo*> plugins;
 };
 
 /** Write a string vector `lines` as lines to `FILE` 
@@ -97,21 +311,13 @@ int lv2_dyn_manifest_open (LV2_Dyn_Manifest_Handle* handle, const LV2_Feature* c
 /** @private */
 LV2_SYMBOL_EXPORT
 int lv2_dyn_manifest_get_subjects (LV2_Dyn_Manifest_Handle handle, FILE* fp) {
-    auto* manifest = static_cast<lvtk::DynManifest*> (handle);
-    std::stringstream lines;
-    if (! manifest->get_subjects (lines))
-        return 1;
-    return lvtk::write_lines (lines, fp) ? 0 : 2;
+    return static_cast<lvtk::DynManifest*> (handle)->write_subjects_file (fp);
 }
 
 /** @private */
 LV2_SYMBOL_EXPORT
 int lv2_dyn_manifest_get_data (LV2_Dyn_Manifest_Handle handle, FILE* fp, const char* uri) {
-    auto* manifest = static_cast<lvtk::DynManifest*> (handle);
-    std::stringstream lines;
-    if (! manifest->get_data (lines, uri))
-        return 1;
-    return lvtk::write_lines (lines, fp) ? 0 : 2;
+    return static_cast<lvtk::DynManifest*> (handle)->write_data_file (fp, uri);
 }
 
 /** @private */
@@ -43,6 +43,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <lv2/buf-size/buf-size.h>
 #include <lvtk/ext/options.hpp>
 #include <lvtk/ext/urid.hpp>
@@ -95,9 +97,21 @@ struct BufferDetails final {
                 nominal = *(uint32_t*) opt.value;
         }
     }
+
+    bool operator== (const BufferDetails& o) const noexcept {
+        return min == o.min && max == o.max && nominal == o.nominal && sequence_size == o.sequence_size;
+    }
+
+    bool operator!= (const BufferDetails& o) const noexcept { return ! operator== (o); }
 };
 
 /** LV2 Buf Size Extension
+
+    Details are updated when the host sets block length options, if the
+    plugin also uses @ref Options.  Updates are written to a spare copy
+    which is then swapped in, so buffer_details() never returns a
+    partially updated value.
+
     @headerfile lvtk/ext/bufsize.hpp
  */
 template <class I>
@@ -112,7 +126,7 @@ struct BufSize : NullExtension {
             if (! options)
                 options.set (f);
             if (map && options) {
-                details.apply_options (map, options);
+                details[0].apply_options (map, options);
                 break;
             }
         }
@@ -125,10 +139,28 @@ struct BufSize : NullExtension {
      
         @returns The host provided buffer details
      */
-    const BufferDetails& buffer_details() const { return details; }
+    const BufferDetails& buffer_details() const {
+        return details[active.load (std::memory_order_acquire)];
+    }
+
+    /** Apply buffer options. Called by @ref Options when the host sets options.
+
+        @returns true if the details changed
+     */
+    bool update_buffer_details (Map& map, const Option* options) {
+        const uint32_t current = active.load (std::memory_order_relaxed);
+        auto& next = details[current ^ 1];
+        next = details[current];
+        next.apply_options (map, options);
+        if (next == details[current])
+            return false;
+        active.store (current ^ 1, std::memory_order_release);
+        return true;
+    }
 
 private:
-    BufferDetails details;
+    BufferDetails details[2];
+    std::atomic<uint32_t> active { 0 };
 };
 /* @} */
 } // namespace lvtk
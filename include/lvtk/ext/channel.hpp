@@ -0,0 +1,307 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+/** @defgroup channel Channels
+    Shared memory from plugin to UI
+
+    When the UI runs in the plugin's process, high rate data like meters
+    and scope frames can be read straight from the plugin instead of being
+    serialized to atoms and passed through the host.
+
+    The plugin publishes @ref SharedChannel "SharedChannels" with the
+    @ref Channels extension, the UI finds them with @ref ChannelAccess,
+    which needs the host's instance-access and data-access features.
+    When the UI doesn't find a channel, the plugin sends the same data as
+    atoms and a @ref ChannelReader reads whichever arrives.  A channel has
+    one reader at a time, so a second UI of the same instance reads atoms.
+
+    <h3>Example</h3>
+    @code
+    struct Scope { float samples[512]; };
+
+    // plugin
+    class MyPlug : public lvtk::Plugin<MyPlug, lvtk::Channels> {
+    public:
+        MyPlug (const lvtk::Args& args) : Plugin (args) {
+            add_channel (MY_URI "#scope", scope);
+        }
+
+        void run (uint32_t nframes) {
+            capture (scope.write_buffer(), nframes);
+            scope.publish();
+            if (! scope.attached())
+                send_atom (notify_port, scope_type, sizeof (Scope), &scope.write_buffer());
+        }
+
+    private:
+        lvtk::SharedChannel<Scope> scope;
+    };
+
+    // ui
+    class MyUI : public lvtk::UI<MyUI, lvtk::ChannelAccess, lvtk::Idle> {
+    public:
+        MyUI (const lvtk::UIArgs& args) : UI (args) {
+            scope.set_channel (find_channel<Scope> (MY_URI "#scope"));
+            port_events().on_atom (notify_port, [this] (const LV2_Atom& a) { scope.receive (a); });
+        }
+
+        int idle() {
+            Scope frame;
+            if (scope.read (frame))
+                view.draw (frame);
+            return 0;
+        }
+
+    private:
+        lvtk::ChannelReader<Scope> scope;
+    };
+    @endcode
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <lv2/atom/atom.h>
+#include <lvtk/ext/data_access.hpp>
+#include <lvtk/ext/extension.hpp>
+#include <lvtk/ext/instance_access.hpp>
+#include <lvtk/triple_buffer.hpp>
+
+/** URI of the plugin's channel interface, see @ref LVTK_Channel_Interface */
+#define LVTK_CHANNEL__interface "http://lvtk.org/ns/channel#interface"
+
+/** Extension data returned for LVTK_CHANNEL__interface
+    @ingroup channel
+ */
+typedef struct {
+    /** Get a channel of a plugin instance.
+        @param instance The plugin instance
+        @param uri      URI of the channel
+        @param size     Size of the channel's value type
+        @param type     Name of the channel's value type
+        @returns the channel, or NULL if not found or the type is wrong
+     */
+    void* (*channel) (LV2_Handle instance, const char* uri, uint32_t size, const char* type);
+} LVTK_Channel_Interface;
+
+namespace lvtk {
+/** @private */
+namespace detail {
+/** Names T the same way in plugin and UI binaries built by the same
+    compiler.  An address based key wouldn't survive hidden visibility,
+    which gives each binary its own copy.
+ */
+template <typename T>
+inline const char* channel_type() noexcept {
+#if defined(_MSC_VER)
+    return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
+}
+} // namespace detail
+
+/** Type independent part of a @ref SharedChannel
+    @ingroup channel
+    @headerfile lvtk/ext/channel.hpp
+ */
+class ChannelState {
+public:
+    /** @returns true if a UI is reading the channel directly */
+    bool attached() const noexcept { return readers.load (std::memory_order_relaxed) > 0; }
+
+    /** @returns the size of the value type */
+    uint32_t value_size() const noexcept { return size; }
+
+    /** @private
+        @returns false if another reader is attached */
+    bool attach() noexcept {
+        uint32_t none = 0;
+        return readers.compare_exchange_strong (none, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    /** @private */
+    void detach() noexcept { readers.store (0, std::memory_order_release); }
+
+protected:
+    explicit ChannelState (uint32_t s) : size (s) {}
+
+private:
+    std::atomic<uint32_t> readers { 0 };
+    const uint32_t size;
+};
+
+/** A triple buffered value shared from plugin to UI.
+
+    Writing never blocks, so it is safe from run().  Check `attached()`
+    to decide whether the data also needs to be sent as an atom.
+
+    @ingroup channel
+    @headerfile lvtk/ext/channel.hpp
+ */
+template <typename T>
+class SharedChannel final : public ChannelState {
+public:
+    SharedChannel() : ChannelState (sizeof (T)) {}
+
+    /** @returns the value to fill before `publish`. Plugin only. */
+    T& write_buffer() noexcept { return buffer.write_buffer(); }
+    /** Make the write buffer visible to the UI. Plugin only. */
+    void publish() noexcept { buffer.publish(); }
+    /** Copy and publish a value. Plugin only. */
+    void write (const T& value) noexcept { buffer.write (value); }
+
+    /** Copy the latest value if there is a new one. UI only.
+        @returns true if `value` was set
+     */
+    bool read (T& value) noexcept { return buffer.read (value); }
+
+private:
+    TripleBuffer<T> buffer;
+};
+
+/** Publishes @ref SharedChannel "SharedChannels" to UIs in the same process
+    @ingroup channel
+    @headerfile lvtk/ext/channel.hpp
+ */
+template <class I>
+struct Channels : Extension<I> {
+    /** @private */
+    Channels (const FeatureList&) {}
+
+    /** Publish a channel. Call from the plugin's constructor.
+        The channel must outlive the plugin's UIs, usually by being a
+        member of the plugin.
+     */
+    template <typename T>
+    void add_channel (const std::string& uri, SharedChannel<T>& channel) {
+        channels.push_back ({ uri, detail::channel_type<T>(), &channel, static_cast<void*> (&channel) });
+    }
+
+protected:
+    /** @private */
+    static void map_extension_data (ExtensionMap& dmap) {
+        static const LVTK_Channel_Interface _channel_iface = { _channel };
+        dmap[LVTK_CHANNEL__interface] = &_channel_iface;
+    }
+
+private:
+    struct Entry {
+        std::string uri;
+        const char* type;
+        ChannelState* state;
+        void* channel; // the SharedChannel<T>*, as the UI casts it back
+    };
+    std::vector<Entry> channels;
+
+    static void* _channel (LV2_Handle instance, const char* uri, uint32_t size, const char* type) {
+        auto* const plugin = static_cast<I*> (instance);
+        for (const auto& e : plugin->Channels<I>::channels) {
+            if (e.uri != uri)
+                continue;
+            const bool same = e.state->value_size() == size && type != nullptr
+                              && std::strcmp (e.type, type) == 0;
+            return same ? e.channel : nullptr;
+        }
+        return nullptr;
+    }
+};
+
+/** Finds a plugin's @ref SharedChannel "SharedChannels" from a UI.
+
+    Requires the host's instance-access and data-access features, which
+    are only given when the UI runs in the plugin's process.
+
+    @ingroup channel
+    @headerfile lvtk/ext/channel.hpp
+ */
+template <class I>
+struct ChannelAccess : NullExtension {
+    /** @private */
+    ChannelAccess (const FeatureList& features) {
+        for (const auto& f : features) {
+            if (! instance)
+                instance.set (f);
+            if (! data_access)
+                data_access.set (f);
+        }
+    }
+
+    ~ChannelAccess() {
+        for (auto* channel : attached)
+            channel->detach();
+    }
+
+    /** Find a channel of the plugin.
+        @param uri  URI the plugin published the channel with
+        @returns the channel, or nullptr if not available or another
+                 UI is already reading it
+     */
+    template <typename T>
+    SharedChannel<T>* find_channel (const std::string& uri) {
+        const auto iface = static_cast<const LVTK_Channel_Interface*> (data_access (LVTK_CHANNEL__interface));
+        if (iface == nullptr || instance.get() == nullptr)
+            return nullptr;
+        auto channel = static_cast<SharedChannel<T>*> (
+            iface->channel (instance.get(), uri.c_str(), sizeof (T), detail::channel_type<T>()));
+        if (channel == nullptr || ! channel->attach())
+            return nullptr;
+        attached.push_back (channel);
+        return channel;
+    }
+
+private:
+    InstanceHandle instance;
+    ExtensionData data_access;
+    std::vector<ChannelState*> attached;
+};
+
+/** Reads a value from a @ref SharedChannel, or from atoms when the
+    channel isn't available.
+
+    @ingroup channel
+    @headerfile lvtk/ext/channel.hpp
+ */
+template <typename T>
+class ChannelReader final {
+public:
+    ChannelReader() = default;
+
+    /** Read from a shared channel. Passing nullptr reads from atoms. */
+    void set_channel (SharedChannel<T>* c) noexcept { channel = c; }
+
+    /** @returns true if reading from a shared channel */
+    bool shared() const noexcept { return channel != nullptr; }
+
+    /** Take the value from an atom whose body is a T. Ignored when
+        reading from a shared channel or if the size doesn't match. */
+    void receive (const LV2_Atom& atom) noexcept {
+        if (channel != nullptr || atom.size != sizeof (T))
+            return;
+        std::memcpy (&latest, &atom + 1, sizeof (T));
+        fresh = true;
+    }
+
+    /** Copy the latest value if there is a new one.
+        @returns true if `value` was set
+     */
+    bool read (T& value) noexcept {
+        if (channel != nullptr)
+            return channel->read (value);
+        if (! fresh)
+            return false;
+        value = latest;
+        fresh = false;
+        return true;
+    }
+
+private:
+    SharedChannel<T>* channel = nullptr;
+    T latest {};
+    bool fresh = false;
+};
+
+} // namespace lvtk
@@ -16,18 +16,624 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
 #include <lv2/log/log.h>
 #include <lvtk/ext/extension.hpp>
+#include <lvtk/ring_buffer.hpp>
 
 /** @defgroup log Log
     Logging support
 */
 
+/** Default size in bytes of a deferred Logger's queue */
+#ifndef LVTK_LOG_RING_SIZE
+    #define LVTK_LOG_RING_SIZE 8192
+#endif
+
+/** Largest encoded arguments of one deferred message. Longer strings are truncated */
+#ifndef LVTK_LOG_MAX_RECORD
+    #define LVTK_LOG_MAX_RECORD 256
+#endif
+
 namespace lvtk {
 
+/** @private */
+namespace detail {
+
+/** A parsed printf conversion */
+struct LogSpec {
+    enum Length : uint8_t { none, hh, h, l, ll, j, z, t, L };
+
+    const char* flags = nullptr;
+    size_t n_flags = 0;
+    const char* width = nullptr;
+    size_t n_width = 0;
+    const char* precision = nullptr;
+    size_t n_precision = 0;
+    bool star_width = false;
+    bool star_precision = false;
+    bool has_precision = false;
+    Length length = none;
+    char conversion = 0;
+};
+
+constexpr bool log_char_in (const char* set, char c) noexcept {
+    for (; *set != '\0'; ++set)
+        if (*set == c)
+            return true;
+    return false;
+}
+
+/** Parse the conversion following a '%'.
+    @returns the character after it, or nullptr if not supported
+ */
+constexpr const char* parse_log_spec (const char* p, LogSpec& spec) noexcept {
+    auto digits = [&p]() {
+        while (*p >= '0' && *p <= '9')
+            ++p;
+    };
+
+    spec = LogSpec();
+    spec.flags = p;
+    while (*p != '\0' && log_char_in ("-+ #0", *p))
+        ++p;
+    spec.n_flags = (size_t) (p - spec.flags);
+
+    if (*p == '*') {
+        spec.star_width = true;
+        ++p;
+    } else {
+        spec.width = p;
+        digits();
+        spec.n_width = (size_t) (p - spec.width);
+    }
+
+    if (*p == '.') {
+        spec.has_precision = true;
+        if (*++p == '*') {
+            spec.star_precision = true;
+            ++p;
+        } else {
+            spec.precision = p;
+            digits();
+            spec.n_precision = (size_t) (p - spec.precision);
+        }
+    }
+
+    switch (*p) {
+        case 'h':
+            spec.length = *++p == 'h' ? (++p, LogSpec::hh) : LogSpec::h;
+            break;
+        case 'l':
+            spec.length = *++p == 'l' ? (++p, LogSpec::ll) : LogSpec::l;
+            break;
+        case 'j': spec.length = LogSpec::j, ++p; break;
+        case 'z': spec.length = LogSpec::z, ++p; break;
+        case 't': spec.length = LogSpec::t, ++p; break;
+        case 'L': spec.length = LogSpec::L, ++p; break;
+        default: break;
+    }
+
+    spec.conversion = *p;
+    if (*p == '\0' || ! log_char_in ("diouxXcspeEfFgGaA", *p))
+        return nullptr;
+    return p + 1;
+}
+
+/** Binary arguments of a deferred log message.
+
+    Each argument is a tag byte followed by its value.  Integers are
+    zigzag/LEB128 varints and doubles which are exact as floats take four
+    bytes, so typical messages encode smaller than their text.
+ */
+struct LogRecord {
+    enum Tag : uint8_t { Int = 'i', Uint = 'u', Float = 'f', Double = 'd', String = 's', Pointer = 'p' };
+
+    uint8_t data[LVTK_LOG_MAX_RECORD];
+    uint32_t size = 0;
+
+    bool put_int (int64_t value) noexcept {
+        return put_varint (Int, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+    }
+
+    bool put_uint (uint64_t value) noexcept { return put_varint (Uint, value); }
+
+    bool put_double (double value) noexcept {
+        const auto single = (float) value;
+        if ((double) single == value)
+            return put (Float, single);
+        return put (Double, value);
+    }
+
+    bool put_pointer (const void* value) noexcept { return put (Pointer, value); }
+
+    bool put_string (const char* str) noexcept {
+        if (str == nullptr)
+            str = "(null)";
+        const size_t space = sizeof (data) - size;
+        if (space < 2)
+            return false;
+        // truncate to what fits after the tag and length
+        auto length = strnlen (str, space - 2);
+        while (1 + varint_size (length) + length > space)
+            --length;
+        if (! put_varint (String, length))
+            return false;
+        std::memcpy (data + size, str, length);
+        size += (uint32_t) length;
+        return true;
+    }
+
+private:
+    template <typename T>
+    bool put (Tag tag, T value) noexcept {
+        if (size + 1 + sizeof (T) > sizeof (data))
+            return false;
+        data[size++] = tag;
+        std::memcpy (data + size, &value, sizeof (T));
+        size += sizeof (T);
+        return true;
+    }
+
+    static uint32_t varint_size (uint64_t value) noexcept {
+        uint32_t n = 1;
+        for (; value >= 0x80; value >>= 7)
+            ++n;
+        return n;
+    }
+
+    bool put_varint (Tag tag, uint64_t value) noexcept {
+        if (size + 1 + varint_size (value) > sizeof (data))
+            return false;
+        data[size++] = tag;
+        while (value >= 0x80) {
+            data[size++] = (uint8_t) (value | 0x80);
+            value >>= 7;
+        }
+        data[size++] = (uint8_t) value;
+        return true;
+    }
+};
+
+/** Reads arguments written by LogRecord */
+struct LogReader {
+    const uint8_t* data;
+    const uint8_t* end;
+
+    uint8_t peek() const noexcept { return data < end ? *data : 0; }
+
+    bool get_int (int64_t& value) noexcept {
+        uint64_t raw = 0;
+        if (! get_varint (LogRecord::Int, raw))
+            return false;
+        value = (int64_t) (raw >> 1) ^ -(int64_t) (raw & 1);
+        return true;
+    }
+
+    bool get_uint (uint64_t& value) noexcept { return get_varint (LogRecord::Uint, value); }
+
+    bool get_double (double& value) noexcept {
+        float single = 0.f;
+        if (peek() == LogRecord::Float && get (LogRecord::Float, single)) {
+            value = single;
+            return true;
+        }
+        return get (LogRecord::Double, value);
+    }
+
+    bool get_pointer (const void*& value) noexcept { return get (LogRecord::Pointer, value); }
+
+    bool get_string (std::string& value) {
+        uint64_t length = 0;
+        if (! get_varint (LogRecord::String, length) || length > (uint64_t) (end - data))
+            return false;
+        value.assign ((const char*) data, (size_t) length);
+        data += length;
+        return true;
+    }
+
+private:
+    template <typename T>
+    bool get (uint8_t tag, T& value) noexcept {
+        if (peek() != tag || (size_t) (end - data) < 1 + sizeof (T))
+            return false;
+        std::memcpy (&value, data + 1, sizeof (T));
+        data += 1 + sizeof (T);
+        return true;
+    }
+
+    bool get_varint (uint8_t tag, uint64_t& value) noexcept {
+        if (peek() != tag)
+            return false;
+        ++data;
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && data < end; shift += 7) {
+            const uint8_t b = *data++;
+            value |= (uint64_t) (b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+/** @returns the record tag used for arguments of type T, or zero */
+template <typename T>
+constexpr uint8_t log_tag() noexcept {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same<U, const char*>::value || std::is_same<U, char*>::value)
+        return LogRecord::String;
+    else if constexpr (std::is_floating_point<U>::value)
+        return LogRecord::Double;
+    else if constexpr (std::is_integral<U>::value || std::is_enum<U>::value)
+        return std::is_signed<U>::value ? LogRecord::Int : LogRecord::Uint;
+    else if constexpr (std::is_pointer<U>::value)
+        return LogRecord::Pointer;
+    else
+        return 0;
+}
+
+/** @returns true if a conversion accepts an argument with `tag` */
+constexpr bool log_conversion_accepts (char conversion, uint8_t tag) noexcept {
+    switch (conversion) {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            return tag == LogRecord::Int || tag == LogRecord::Uint;
+        case 's':
+            return tag == LogRecord::String;
+        case 'p':
+            return tag == LogRecord::Pointer;
+        default:
+            return tag == LogRecord::Double;
+    }
+}
+
+/** @returns true if `fmt` takes exactly the arguments Args */
+template <typename... Args>
+constexpr bool check_log_format (const char* fmt) noexcept {
+    constexpr uint8_t tags[] = { log_tag<Args>()..., 0 };
+    size_t arg = 0;
+    for (const char* p = fmt; *p != '\0';) {
+        if (*p++ != '%')
+            continue;
+        if (*p == '%') {
+            ++p;
+            continue;
+        }
+
+        LogSpec spec;
+        if ((p = parse_log_spec (p, spec)) == nullptr)
+            return false;
+        if (spec.star_width && (arg >= sizeof... (Args) || ! log_conversion_accepts ('d', tags[arg++])))
+            return false;
+        if (spec.star_precision && (arg >= sizeof... (Args) || ! log_conversion_accepts ('d', tags[arg++])))
+            return false;
+        if (arg >= sizeof... (Args) || ! log_conversion_accepts (spec.conversion, tags[arg++]))
+            return false;
+    }
+    return arg == sizeof... (Args);
+}
+
+/** FNV-1a hash of a format string */
+constexpr uint32_t log_format_id (const char* fmt) noexcept {
+    uint32_t hash = 2166136261u;
+    for (; *fmt != '\0'; ++fmt)
+        hash = (hash ^ (uint8_t) *fmt) * 16777619u;
+    return hash;
+}
+
+template <typename T>
+bool put_log_arg (LogRecord& rec, const T& value) noexcept {
+    constexpr auto tag = log_tag<T>();
+    static_assert (tag != 0, "Unsupported log argument type");
+    if constexpr (tag == LogRecord::String)
+        return rec.put_string (value);
+    else if constexpr (tag == LogRecord::Double)
+        return rec.put_double ((double) value);
+    else if constexpr (tag == LogRecord::Int)
+        return rec.put_int ((int64_t) value);
+    else if constexpr (tag == LogRecord::Uint)
+        return rec.put_uint ((uint64_t) value);
+    else
+        return rec.put_pointer ((const void*) value);
+}
+
+/** Encode printf arguments for later formatting
+    @returns false if the format isn't supported or the arguments don't fit
+ */
+inline bool encode_log_args (LogRecord& rec, const char* fmt, va_list args) noexcept {
+    for (const char* p = fmt; *p != '\0';) {
+        if (*p++ != '%')
+            continue;
+        if (*p == '%') {
+            ++p;
+            continue;
+        }
+
+        LogSpec spec;
+        if ((p = parse_log_spec (p, spec)) == nullptr)
+            return false;
+        if (spec.star_width && ! rec.put_int (va_arg (args, int)))
+            return false;
+        if (spec.star_precision && ! rec.put_int (va_arg (args, int)))
+            return false;
+
+        bool ok = false;
+        switch (spec.conversion) {
+            case 'd':
+            case 'i': {
+                int64_t value;
+                switch (spec.length) {
+                    case LogSpec::l: value = va_arg (args, long); break;
+                    case LogSpec::ll: value = va_arg (args, long long); break;
+                    case LogSpec::j: value = va_arg (args, intmax_t); break;
+                    case LogSpec::z: value = (int64_t) va_arg (args, size_t); break;
+                    case LogSpec::t: value = va_arg (args, ptrdiff_t); break;
+                    default: value = va_arg (args, int); break;
+                }
+                ok = rec.put_int (value);
+                break;
+            }
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X': {
+                uint64_t value;
+                switch (spec.length) {
+                    case LogSpec::l: value = va_arg (args, unsigned long); break;
+                    case LogSpec::ll: value = va_arg (args, unsigned long long); break;
+                    case LogSpec::j: value = va_arg (args, uintmax_t); break;
+                    case LogSpec::z: value = va_arg (args, size_t); break;
+                    case LogSpec::t: value = (uint64_t) va_arg (args, ptrdiff_t); break;
+                    default: value = va_arg (args, unsigned int); break;
+                }
+                ok = rec.put_uint (value);
+                break;
+            }
+            case 'c':
+                ok = rec.put_int (va_arg (args, int));
+                break;
+            case 's':
+                ok = rec.put_string (va_arg (args, const char*));
+                break;
+            case 'p':
+                ok = rec.put_pointer (va_arg (args, void*));
+                break;
+            default:
+                ok = rec.put_double (spec.length == LogSpec::L ? (double) va_arg (args, long double)
+                                                               : va_arg (args, double));
+                break;
+        }
+
+        if (! ok)
+            return false;
+    }
+
+    return true;
+}
+
+/** Format a deferred message into `out` */
+inline void format_log_record (std::string& out, const char* fmt, const uint8_t* data, uint32_t size) {
+    LogReader reader { data, data + size };
+    auto append = [&out] (const char* spec, auto value) {
+        const int length = std::snprintf (nullptr, 0, spec, value);
+        if (length <= 0)
+            return;
+        const size_t pos = out.size();
+        out.resize (pos + (size_t) length + 1);
+        std::snprintf (&out[pos], (size_t) length + 1, spec, value);
+        out.resize (pos + (size_t) length);
+    };
+
+    out.clear();
+    for (const char* p = fmt; *p != '\0';) {
+        const char* literal = std::strchr (p, '%');
+        if (literal == nullptr) {
+            out.append (p);
+            break;
+        }
+        out.append (p, (size_t) (literal - p));
+        p = literal + 1;
+        if (*p == '%') {
+            out.push_back ('%');
+            ++p;
+            continue;
+        }
+
+        LogSpec spec;
+        if ((p = parse_log_spec (p, spec)) == nullptr)
+            return;
+
+        // rebuild the conversion for the stored argument's type
+        std::string conv ("%");
+        conv.append (spec.flags, spec.n_flags);
+        int64_t star = 0;
+        if (spec.star_width) {
+            if (! reader.get_int (star))
+                return;
+            conv += std::to_string (star);
+        } else {
+            conv.append (spec.width, spec.n_width);
+        }
+        if (spec.has_precision) {
+            conv.push_back ('.');
+            if (spec.star_precision) {
+                if (! reader.get_int (star))
+                    return;
+                conv += std::to_string (star);
+            } else {
+                conv.append (spec.precision, spec.n_precision);
+            }
+        }
+
+        switch (reader.peek()) {
+            case LogRecord::Int: {
+                int64_t value = 0;
+                if (! reader.get_int (value))
+                    return;
+                conv += spec.conversion == 'c' ? "c" : std::string ("ll") + spec.conversion;
+                if (spec.conversion == 'c')
+                    append (conv.c_str(), (int) value);
+                else
+                    append (conv.c_str(), (long long) value);
+                break;
+            }
+            case LogRecord::Uint: {
+                uint64_t value = 0;
+                if (! reader.get_uint (value))
+                    return;
+                conv += spec.conversion == 'c' ? "c" : std::string ("ll") + spec.conversion;
+                if (spec.conversion == 'c')
+                    append (conv.c_str(), (int) value);
+                else
+                    append (conv.c_str(), (unsigned long long) value);
+                break;
+            }
+            case LogRecord::Float:
+            case LogRecord::Double: {
+                double value = 0.0;
+                if (! reader.get_double (value))
+                    return;
+                conv.push_back (spec.conversion);
+                append (conv.c_str(), value);
+                break;
+            }
+            case LogRecord::Pointer: {
+                const void* value = nullptr;
+                if (! reader.get_pointer (value))
+                    return;
+                conv.push_back ('p');
+                append (conv.c_str(), value);
+                break;
+            }
+            case LogRecord::String: {
+                std::string value;
+                if (! reader.get_string (value))
+                    return;
+                conv.push_back ('s');
+                append (conv.c_str(), value.c_str());
+                break;
+            }
+            default:
+                return;
+        }
+    }
+}
+
+/** Queue shared by copies of a deferred Logger */
+struct LogQueue {
+    struct Header {
+        uint32_t type;
+        uint32_t size;
+        const char* format;
+    };
+
+    explicit LogQueue (uint32_t size) : ring (size) {}
+
+    RingBuffer ring;
+    std::atomic<uint32_t> dropped { 0 };
+    uint32_t reported = 0;
+    std::string text;
+    uint8_t scratch[LVTK_LOG_MAX_RECORD];
+};
+
+} // namespace detail
+
+/** A printf style format checked against its argument types.
+
+    Declare formats `constexpr` so a mismatch is a compile error.
+
+    @code
+        static constexpr lvtk::LogFormat<uint32_t, float> xrun_format ("xrun at %u, load %.2f\n");
+        log.write (trace_urid, xrun_format, frame, load);
+    @endcode
+
+    @tparam Args The argument types
+    @headerfile lvtk/ext/log.hpp
+    @ingroup log
+ */
+template <typename... Args>
+struct LogFormat final {
+    /** @throws std::invalid_argument if the format doesn't match Args.
+        Evaluated at compile time when the format is constexpr */
+    constexpr LogFormat (const char* fmt)
+        : format (fmt), id (detail::log_format_id (fmt)) {
+        if (! detail::check_log_format<Args...> (fmt))
+            throw std::invalid_argument ("lvtk: log format doesn't match its arguments");
+    }
+
+    const char* const format; /**< The format string */
+    const uint32_t id;        /**< Hash of the format string */
+};
+
+/** Receives encoded log records from a deferred @ref Logger.
+    @see Logger::flush
+    @headerfile lvtk/ext/log.hpp
+    @ingroup log
+ */
+struct LogSink {
+    virtual ~LogSink() = default;
+
+    /** Handle one record.
+
+        @param type     Log type URID
+        @param format   The format string
+        @param args     Encoded arguments. Use @ref format_log to get text
+        @param size     Size of `args` in bytes
+     */
+    virtual void record (uint32_t type, const char* format, const void* args, uint32_t size) = 0;
+};
+
+/** Format encoded log arguments, as passed to a @ref LogSink
+    @ingroup log
+ */
+inline std::string format_log (const char* format, const void* args, uint32_t size) {
+    std::string text;
+    detail::format_log_record (text, format, static_cast<const uint8_t*> (args), size);
+    return text;
+}
+
 /** Wrapper around LV2_Log_Log
     
     Use this on the stack to log messages
+
+    <h3>Deferred Logging</h3>
+    Most hosts lock and format on the calling thread, so logging from the
+    audio thread can cause xruns.  After calling `set_deferred (true)`,
+    `printf` only encodes the format pointer and its arguments into a
+    lock-free queue.  A non-realtime thread then calls `flush` to format
+    them and pass them to the host.  Messages which don't fit in the queue
+    are dropped and counted.
+
+    In deferred mode the format string must outlive the call to `flush`,
+    for example a string literal.  String arguments are copied.  Only one
+    thread at a time may log through a deferred Logger and its copies.
+
+    @code
+        // constructor
+        log.set_deferred (true);
+
+        // run()
+        log.printf (trace_urid, "xrun at frame %u\n", frame);
+
+        // Worker::work, or some other thread
+        log.flush();
+    @endcode
+
     @headerfile lvtk/ext/log.hpp
     @ingroup log
  */
@@ -41,7 +647,7 @@ struct Logger final : FeatureData<LV2_Log_Log> {
     /** Log log:Trace with stream operator */
     inline void operator<< (const char* out) const {
         if (Trace > 0)
-            this->printf (Trace, out);
+            this->printf (Trace, "%s", out);
     }
 
     /** Log message with va_list 
@@ -49,11 +655,16 @@ struct Logger final : FeatureData<LV2_Log_Log> {
         @param type     LV2_URID type to log
         @fmt            Format / message
         @ap             Arguments
+        @returns the host's result, or zero when deferred
     */
     inline int vprintf (uint32_t type, const char* fmt, va_list ap) const {
-        if (data != nullptr)
-            return data->vprintf (data->handle, type, fmt, ap);
-        return 0;
+        if (data == nullptr)
+            return 0;
+        if (queue != nullptr) {
+            push (type, fmt, ap);
+            return 0;
+        }
+        return data->vprintf (data->handle, type, fmt, ap);
     }
 
     /** Log message with var args
@@ -70,6 +681,82 @@ struct Logger final : FeatureData<LV2_Log_Log> {
         return res;
     }
 
+    /** Log a message with a checked format.
+
+        Arguments are encoded to a compact binary record.  When deferred the
+        record is queued as is and is formatted by `flush`, or not at all if
+        flushed to a binary @ref LogSink.  Otherwise it is formatted now.
+
+        @param type     LV2_URID type to log
+        @param fmt      The format
+        @param args     Arguments, converted to the format's types
+        @returns false if the message was dropped
+     */
+    template <typename... F, typename... A>
+    bool write (uint32_t type, const LogFormat<F...>& fmt, const A&... args) const {
+        static_assert (sizeof... (F) == sizeof... (A), "Wrong number of log arguments");
+        if (data == nullptr)
+            return false;
+
+        detail::LogRecord record;
+        bool encoded = true;
+        (void) (... && (encoded = detail::put_log_arg<F> (record, static_cast<F> (args))));
+        if (queue != nullptr)
+            return enqueue (encoded, type, fmt.format, record);
+        if (! encoded)
+            return false;
+
+        std::string text;
+        detail::format_log_record (text, fmt.format, record.data, record.size);
+        host_printf (data, type, "%s", text.c_str());
+        return true;
+    }
+
+    /** Enable or disable deferred logging. Not realtime safe.
+
+        @param deferred     True to queue messages until `flush` is called
+        @param queue_size   Size of the message queue in bytes
+     */
+    void set_deferred (bool deferred, uint32_t queue_size = LVTK_LOG_RING_SIZE) {
+        if (deferred && queue == nullptr)
+            queue = std::make_shared<detail::LogQueue> (queue_size);
+        else if (! deferred && queue != nullptr) {
+            flush();
+            queue.reset();
+        }
+    }
+
+    /** @returns true if messages are queued until `flush` */
+    bool deferred() const noexcept { return queue != nullptr; }
+
+    /** Format queued messages and pass them to the host. Not realtime safe.
+
+        Logs a warning first if messages were dropped since the last flush.
+
+        @returns the number of messages passed to the host
+     */
+    uint32_t flush() const {
+        if (queue == nullptr || data == nullptr)
+            return 0;
+        return flush_to (nullptr);
+    }
+
+    /** Pass queued records to a sink without formatting them. Not realtime safe.
+
+        @returns the number of records passed to the sink
+     */
+    uint32_t flush (LogSink& sink) const {
+        if (queue == nullptr)
+            return 0;
+        return flush_to (&sink);
+    }
+
+    /** @returns the total number of deferred messages dropped because the
+        queue was full or their arguments were too large */
+    uint32_t dropped() const noexcept {
+        return queue != nullptr ? queue->dropped.load (std::memory_order_relaxed) : 0;
+    }
+
     /** Assign LV2_URIDs needed to log messages
        
         @param map  A LV2_URID_Map to inititialize with
@@ -88,9 +775,67 @@ private:
     uint32_t Note = 0;
     uint32_t Trace = 0;
     uint32_t Warning = 0;
+    std::shared_ptr<detail::LogQueue> queue;
+
+    uint32_t flush_to (LogSink* sink) const {
+        auto& q = *queue;
+        const uint32_t dropped = q.dropped.load (std::memory_order_relaxed);
+        if (dropped != q.reported) {
+            if (sink == nullptr && Warning > 0)
+                host_printf (data, Warning, "lvtk: dropped %u log messages\n", dropped - q.reported);
+            q.reported = dropped;
+        }
+
+        uint32_t count = 0;
+        detail::LogQueue::Header header;
+        while (q.ring.peek (&header, sizeof (header))
+               && q.ring.read_space() >= sizeof (header) + header.size) {
+            q.ring.skip (sizeof (header));
+            q.ring.read (q.scratch, header.size);
+            if (sink != nullptr) {
+                sink->record (header.type, header.format, q.scratch, header.size);
+            } else {
+                detail::format_log_record (q.text, header.format, q.scratch, header.size);
+                host_printf (data, header.type, "%s", q.text.c_str());
+            }
+            ++count;
+        }
+
+        return count;
+    }
+
+    static int host_printf (LV2_Log_Log* log, uint32_t type, const char* fmt, ...) {
+        va_list args;
+        va_start (args, fmt);
+        const int res = log->vprintf (log->handle, type, fmt, args);
+        va_end (args);
+        return res;
+    }
+
+    void push (uint32_t type, const char* fmt, va_list ap) const noexcept {
+        detail::LogRecord record;
+        va_list args;
+        va_copy (args, ap);
+        const bool encoded = detail::encode_log_args (record, fmt, args);
+        va_end (args);
+
+        enqueue (encoded, type, fmt, record);
+    }
+
+    bool enqueue (bool encoded, uint32_t type, const char* fmt, const detail::LogRecord& record) const noexcept {
+        const detail::LogQueue::Header header = { type, record.size, fmt };
+        if (encoded && queue->ring.write (&header, sizeof (header), record.data, record.size))
+            return true;
+        queue->dropped.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
 };
 
 /** Adds a @ref Logger `log` to your instance.
+
+    To log from run(), enable deferred logging and flush from the worker
+    thread.  @see Logger
+
     @ingroup log
     @headerfile lvtk/ext/log.hpp
 */
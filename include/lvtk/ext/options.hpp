@@ -20,8 +20,15 @@
 
 #pragma once
 
+#include <type_traits>
+#include <utility>
+
+#include <lv2/atom/atom.h>
 #include <lv2/options/options.h>
+#include <lv2/parameters/parameters.h>
 #include <lvtk/ext/extension.hpp>
+#include <lvtk/ext/urid.hpp>
+#include <lvtk/optional.hpp>
 
 namespace lvtk {
 
@@ -52,7 +59,35 @@ struct OptionsData final : FeatureData<Option> {
     OptionsData() : FeatureData (LV2_OPTIONS__options) {}
 };
 
+/** @private */
+namespace detail {
+template <class I, class = void>
+struct has_buffer_details : std::false_type {};
+
+template <class I>
+struct has_buffer_details<I, std::void_t<decltype (std::declval<I&>().update_buffer_details (std::declval<Map&>(), std::declval<const Option*>()))>>
+    : std::true_type {};
+} // namespace detail
+
 /** Adds support for LV2 options on your instance
+
+    The default `set` applies block length options to @ref BufSize and
+    sample rate changes, then calls `reconfigure()` if anything changed.
+    Override `reconfigure` to re-plan buffers or FFT sizes.
+
+    @code
+    class MyPlug : public lvtk::Plugin<MyPlug, lvtk::BufSize, lvtk::Options> {
+    public:
+        void reconfigure() {
+            const auto& details = buffer_details();
+            if (details.max)
+                fft.resize (*details.max);
+            if (auto rate = options_sample_rate())
+                filter.set_sample_rate (*rate);
+        }
+    };
+    @endcode
+
     @headerfile lvtk/ext/options.hpp
     @ingroup options
  */
@@ -60,14 +95,25 @@ template <class I>
 struct Options : Extension<I> {
     /** @private */
     Options (const FeatureList& features) {
-        for (const auto& f : features)
-            if (host_options.set (f))
-                break;
+        for (const auto& f : features) {
+            if (! host_options)
+                host_options.set (f);
+            if (! map)
+                map.set (f);
+        }
+
+        if (map && host_options)
+            update_sample_rate (host_options.get());
     }
 
     /** @returns Options provided by the host or nullptr if not available */
     const Option* options() const { return host_options.get(); }
 
+    /** @returns the sample rate given by the host in options, if any.
+        This is set at instantiation and updated by `set`.
+     */
+    Optional<double> options_sample_rate() const { return sample_rate; }
+
     /** Get the given options.
 
         Each element of the passed options array MUST have type, subject, and 
@@ -83,12 +129,32 @@ struct Options : Extension<I> {
 
     /** Set the given options.
 
+        Updates @ref BufSize details and the sample rate, and calls
+        `reconfigure()` if either changed.
+
         This function is in the "instantiation" LV2 threading class, so no 
         other instance functions may be called concurrently.
 
         @returns Bitwise OR of OptionsStatus values.
      */
-    uint32_t set (const Option* opts) const { return LV2_OPTIONS_SUCCESS; }
+    uint32_t set (const Option* opts) {
+        if (opts == nullptr || ! map)
+            return LV2_OPTIONS_SUCCESS;
+
+        auto& self = *static_cast<I*> (this);
+        bool changed = update_sample_rate (opts);
+        if constexpr (detail::has_buffer_details<I>::value)
+            changed = self.update_buffer_details (map, opts) || changed;
+
+        if (changed)
+            self.reconfigure();
+        return LV2_OPTIONS_SUCCESS;
+    }
+
+    /** Called by `set` when the host changes block length or sample rate.
+        Not called on the audio thread.
+     */
+    void reconfigure() {}
 
 protected:
     /** @private */
@@ -99,6 +165,32 @@ protected:
 
 private:
     OptionsData host_options;
+    Map map;
+    Optional<double> sample_rate;
+
+    bool update_sample_rate (const Option* opts) {
+        const uint32_t key = map (LV2_PARAMETERS__sampleRate);
+        for (auto opt = opts; opt->key != 0 && opt->value != nullptr; ++opt) {
+            if (opt->key != key)
+                continue;
+
+            double rate = 0.0;
+            if (opt->type == map (LV2_ATOM__Float) && opt->size == sizeof (float))
+                rate = *static_cast<const float*> (opt->value);
+            else if (opt->type == map (LV2_ATOM__Double) && opt->size == sizeof (double))
+                rate = *static_cast<const double*> (opt->value);
+            else if (opt->type == map (LV2_ATOM__Int) && opt->size == sizeof (int32_t))
+                rate = (double) *static_cast<const int32_t*> (opt->value);
+            else if (opt->type == map (LV2_ATOM__Long) && opt->size == sizeof (int64_t))
+                rate = (double) *static_cast<const int64_t*> (opt->value);
+            if (rate <= 0.0 || (sample_rate && *sample_rate == rate))
+                return false;
+
+            sample_rate = rate;
+            return true;
+        }
+        return false;
+    }
 
     static uint32_t _get (LV2_Handle handle, LV2_Options_Option* options) {
         return (static_cast<I*> (handle))->get (options);
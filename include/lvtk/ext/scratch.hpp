@@ -0,0 +1,278 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <lvtk/ext/bufsize.hpp>
+
+/** Number of scratch buffers preallocated by the Scratch mixin */
+#ifndef LVTK_SCRATCH_BUFFERS
+    #define LVTK_SCRATCH_BUFFERS 8
+#endif
+
+/** Byte alignment of each scratch buffer */
+#ifndef LVTK_SCRATCH_ALIGNMENT
+    #define LVTK_SCRATCH_ALIGNMENT 64
+#endif
+
+/** Block length used when the host provides neither a max nor nominal length */
+#ifndef LVTK_SCRATCH_FALLBACK_BLOCK_LENGTH
+    #define LVTK_SCRATCH_FALLBACK_BLOCK_LENGTH 8192
+#endif
+
+namespace lvtk {
+
+class ScratchPool;
+
+/** A buffer borrowed from a @ref ScratchPool.
+
+    Returned to the pool when it goes out of scope, in any order.
+    Contents are not cleared.
+
+    @headerfile lvtk/ext/scratch.hpp
+    @ingroup bufsize
+ */
+template <typename T>
+class ScratchBuffer final {
+public:
+    ScratchBuffer() = default;
+    ScratchBuffer (ScratchBuffer&& o) noexcept { *this = std::move (o); }
+    ScratchBuffer& operator= (ScratchBuffer&& o) noexcept {
+        if (this != &o) {
+            release();
+            pool   = o.pool;
+            index  = o.index;
+            buffer = o.buffer;
+            frames = o.frames;
+            o.pool   = nullptr;
+            o.buffer = nullptr;
+            o.frames = 0;
+        }
+        return *this;
+    }
+
+    ~ScratchBuffer() { release(); }
+
+    /** @returns the samples, or nullptr if nothing was available */
+    T* data() const noexcept { return buffer; }
+    /** @returns the number of samples */
+    uint32_t size() const noexcept { return frames; }
+
+    /** Zero the samples */
+    void clear() noexcept {
+        if (buffer != nullptr)
+            std::memset (buffer, 0, sizeof (T) * frames);
+    }
+
+    /** Return to the pool early */
+    inline void release() noexcept;
+
+    T* begin() const noexcept { return buffer; }
+    T* end() const noexcept { return buffer + frames; }
+    T& operator[] (uint32_t i) const noexcept { return buffer[i]; }
+    operator T*() const noexcept { return buffer; }
+
+    /** @returns true if a buffer was available */
+    explicit operator bool() const noexcept { return buffer != nullptr; }
+
+private:
+    friend class ScratchPool;
+    ScratchBuffer (ScratchPool* p, uint32_t i, T* b, uint32_t n) noexcept
+        : pool (p), index (i), buffer (b), frames (n) {}
+
+    ScratchPool* pool = nullptr;
+    uint32_t index = 0;
+    T* buffer = nullptr;
+    uint32_t frames = 0;
+
+    ScratchBuffer (const ScratchBuffer&) = delete;
+    ScratchBuffer& operator= (const ScratchBuffer&) = delete;
+};
+
+/** A fixed set of aligned sample buffers.
+
+    Memory is allocated by `allocate` and borrowed without locking or
+    allocation, so it can be used from the audio thread.  Not thread-safe:
+    borrow from one thread at a time.
+
+    @headerfile lvtk/ext/scratch.hpp
+    @ingroup bufsize
+ */
+class ScratchPool final {
+public:
+    ScratchPool() = default;
+
+    /** Allocate buffers. Not realtime safe.
+
+        Any buffers still borrowed must be released first.
+
+        @param count    Number of buffers
+        @param frames   Samples per buffer, for the largest sample type
+     */
+    void allocate (uint32_t count, uint32_t frames) {
+        const size_t bytes = frames * sizeof (double);
+        stride = (bytes + LVTK_SCRATCH_ALIGNMENT - 1) & ~(size_t) (LVTK_SCRATCH_ALIGNMENT - 1);
+        memory.reset (new uint8_t[stride * count + LVTK_SCRATCH_ALIGNMENT]);
+        const auto addr = reinterpret_cast<uintptr_t> (memory.get());
+        base = memory.get() + ((LVTK_SCRATCH_ALIGNMENT - addr % LVTK_SCRATCH_ALIGNMENT) % LVTK_SCRATCH_ALIGNMENT);
+        slots.assign ((count + 63) / 64, 0);
+        total = count;
+        length = frames;
+        used = 0;
+    }
+
+    /** Borrow a buffer.
+
+        @param frames Number of samples needed
+        @returns a buffer, or an empty one if the pool is used up or
+                 `frames` is larger than the pool's block length
+     */
+    template <typename T = float>
+    ScratchBuffer<T> borrow (uint32_t frames) noexcept {
+        static_assert (sizeof (T) <= sizeof (double), "Scratch sample type too large");
+        if (used >= total || frames > length)
+            return {};
+
+        uint32_t index = 0;
+        for (auto& word : slots) {
+            if (word != ~(uint64_t) 0) {
+                uint32_t bit = 0;
+                while (word & ((uint64_t) 1 << bit))
+                    ++bit;
+                word |= (uint64_t) 1 << bit;
+                index += bit;
+                break;
+            }
+            index += 64;
+        }
+
+        ++used;
+        return { this, index, reinterpret_cast<T*> (base + stride * index), frames };
+    }
+
+    /** @returns the samples per buffer */
+    uint32_t block_length() const noexcept { return length; }
+    /** @returns the total number of buffers */
+    uint32_t capacity() const noexcept { return total; }
+    /** @returns the number of buffers not borrowed */
+    uint32_t available() const noexcept { return total - used; }
+
+private:
+    template <typename T>
+    friend class ScratchBuffer;
+    void release (uint32_t index) noexcept {
+        if (index >= total)
+            return;
+        auto& word = slots[index / 64];
+        const auto mask = (uint64_t) 1 << (index % 64);
+        if ((word & mask) != 0) {
+            word &= ~mask;
+            --used;
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> memory;
+    std::vector<uint64_t> slots; // one bit per borrowed buffer
+    uint8_t* base = nullptr;
+    size_t stride = 0;
+    uint32_t total = 0;
+    uint32_t length = 0;
+    uint32_t used = 0;
+};
+
+template <typename T>
+inline void ScratchBuffer<T>::release() noexcept {
+    if (pool != nullptr)
+        pool->release (index);
+    pool = nullptr;
+    buffer = nullptr;
+    frames = 0;
+}
+
+/** Preallocated scratch buffers sized from the host's block length.
+
+    Buffers hold `maxBlockLength` samples, or `nominalBlockLength` if max
+    isn't given, or LVTK_SCRATCH_FALLBACK_BLOCK_LENGTH if neither is.
+    Borrow them in run() instead of keeping vectors which may need to
+    grow on the audio thread.
+
+    @code
+    class MyPlug : public lvtk::Plugin<MyPlug, lvtk::Scratch> {
+    public:
+        void run (uint32_t nframes) {
+            auto mono = scratch (nframes);
+            if (! mono)
+                return; // more frames than the host said it would send
+            mix_down (mono, nframes);
+            ...
+        } // returned here
+    };
+    @endcode
+
+    @headerfile lvtk/ext/scratch.hpp
+    @ingroup bufsize
+ */
+template <class I>
+struct Scratch : NullExtension {
+    /** @private */
+    Scratch (const FeatureList& features) {
+        Map map;
+        OptionsData options;
+        for (const auto& f : features) {
+            if (! map)
+                map.set (f);
+            if (! options)
+                options.set (f);
+        }
+
+        BufferDetails details;
+        if (map && options)
+            details.apply_options (map, options);
+
+        uint32_t frames = LVTK_SCRATCH_FALLBACK_BLOCK_LENGTH;
+        if (details.max && *details.max > 0)
+            frames = *details.max;
+        else if (details.nominal && *details.nominal > 0)
+            frames = *details.nominal;
+        pool.allocate (LVTK_SCRATCH_BUFFERS, frames);
+    }
+
+    /** Borrow a scratch buffer. Realtime safe.
+
+        @param frames Number of samples needed
+        @returns a buffer, or an empty one if none are left or `frames`
+                 exceeds scratch_block_length()
+     */
+    template <typename T = float>
+    ScratchBuffer<T> scratch (uint32_t frames) noexcept {
+        return pool.template borrow<T> (frames);
+    }
+
+    /** @returns the number of samples each scratch buffer holds */
+    uint32_t scratch_block_length() const noexcept { return pool.block_length(); }
+
+    /** @returns the number of scratch buffers not borrowed */
+    uint32_t scratch_available() const noexcept { return pool.available(); }
+
+    /** Reallocate scratch buffers. Not realtime safe.
+
+        Call from the constructor, `reconfigure()`, or while deactivated,
+        e.g. to get more buffers than LVTK_SCRATCH_BUFFERS or follow a new
+        max block length.
+     */
+    void resize_scratch (uint32_t count, uint32_t frames) {
+        pool.allocate (count, frames);
+    }
+
+private:
+    ScratchPool pool;
+};
+
+} // namespace lvtk
@@ -16,15 +16,120 @@
 
 /** @defgroup state State
     Save and restore state
+
+    <h3>Properties</h3>
+    Instead of writing `save` and `restore` by hand, register the members
+    which make up your state once, in the constructor.  The default `save`
+    and `restore` store and retrieve every registered property with the
+    atom type that matches its C++ type, and skip values whose stored type
+    or size doesn't match.  Requires the URID map feature.
+    @code
+        MyPlugin (const lvtk::Args& args) : Plugin (args) {
+            add_state_property (MY_URI "#gain", &MyPlugin::gain);
+            add_state_property (MY_URI "#name", &MyPlugin::name);
+            add_state_blob (MY_URI "#table", LV2_ATOM__Chunk, &MyPlugin::table);
+        }
+
+        float gain = 1.f;
+        std::string name;
+        std::vector<float> table;
+    @endcode
+
+    <h3>Incremental Saves</h3>
+    Call `state_changed (key)` with the key returned when a property was
+    registered whenever its value changes.  Hosts which pass the
+    @ref StateSince feature to `save` then only receive properties that
+    changed since their previous save.  See @ref StateCache.
+
+    <h3>Thread-Safe Restore</h3>
+    Plugins which declare `state:threadSafeRestore` in their data can be
+    restored while running.  Decode into a new object in `restore`
+    and `post` it to a @ref StateExchange, then `apply` it at the start of
+    `run`.  Objects are never created or deleted on the audio thread.
+    @code
+        StateStatus restore (StateRetrieve& retrieve, uint32_t flags, const FeatureList& features) {
+            auto params = std::make_unique<Params>();
+            decode (retrieve, *params);
+            params_exchange.post (params.release());
+            return LV2_STATE_SUCCESS;
+        }
+
+        void run (uint32_t nframes) {
+            params_exchange.apply();    // or apply ([this] (Params* p) { retire (p); })
+            process (*params_exchange.get(), nframes);
+        }
+    @endcode
+
+    <h3>Compression</h3>
+    Call `set_state_compression (threshold)` to store POD values of at
+    least `threshold` bytes LZ4 compressed, with the type
+    LVTK_STATE__Compressed.  Registered properties are compressed and
+    decompressed automatically.  Hand written code uses `store_value` and
+    `retrieve_value`.  Requires the URID map and unmap features.
+
+    <h3>Files</h3>
+    Large values can be written to a file in the state directory with
+    `save_file`.  Only the file's abstract path is stored, and `restore_file`
+    maps the file back into memory.  Requires the makePath and mapPath
+    features, which hosts pass to `save` and `restore`.
+    @code
+        StateStatus save (StateStore& store, uint32_t flags, const FeatureList& features) {
+            return save_file (store, features, urids.capture, "capture.raw",
+                              capture.data(), capture.size() * sizeof (float));
+        }
+
+        StateStatus restore (StateRetrieve& retrieve, uint32_t flags, const FeatureList& features) {
+            capture_file = restore_file (retrieve, features, urids.capture);
+            return capture_file ? LV2_STATE_SUCCESS : LV2_STATE_ERR_NO_PROPERTY;
+        }
+    @endcode
 */
 
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <lv2/atom/atom.h>
 #include <lv2/state/state.h>
 #include <lvtk/ext/extension.hpp>
+#include <lvtk/ext/urid.hpp>
+#include <lvtk/lz4.hpp>
+#include <lvtk/mapped_file.hpp>
+
+/** URI of the @ref StateSince feature */
+#define LVTK_STATE__since "http://lvtk.org/ns/state#since"
+
+/** Type of values compressed by State::store_value */
+#define LVTK_STATE__Compressed "http://lvtk.org/ns/state#Compressed"
 
 namespace lvtk {
 
+/** Feature data for incremental saves.
+
+    A host passes this to `save` with the generation returned by the
+    previous save.  Plugins using registered properties then only store
+    those which changed after it, and say so by setting `incremental`.
+
+    @ingroup state
+    @headerfile lvtk/ext/state.hpp
+ */
+struct StateSince {
+    /** Host: generation of the previous save, zero to save everything */
+    uint64_t since = 0;
+    /** Plugin: generation of this save */
+    uint64_t generation = 0;
+    /** Plugin: true if only properties changed after `since` were stored */
+    bool incremental = false;
+};
+
 /** Alias of LV2_State_Flags
     @ingroup state
     @headerfile lvtk/ext/state.hpp
@@ -95,6 +200,234 @@ private:
     LV2_State_Store_Function f_store;
 };
 
+/** LV2_State_Make_Path wrapper
+    @ingroup state
+    @headerfile lvtk/ext/state.hpp
+ */
+struct StateMakePath final : FeatureData<LV2_State_Make_Path> {
+    StateMakePath() : FeatureData (LV2_STATE__makePath) {}
+
+    /** Get an absolute path for a file in the state directory.
+        @returns the path, which must be freed, or nullptr
+     */
+    char* operator() (const char* path) const {
+        return data != nullptr ? data->path (data->handle, path) : nullptr;
+    }
+};
+
+/** LV2_State_Map_Path wrapper
+    @ingroup state
+    @headerfile lvtk/ext/state.hpp
+ */
+struct StateMapPath final : FeatureData<LV2_State_Map_Path> {
+    StateMapPath() : FeatureData (LV2_STATE__mapPath) {}
+
+    /** Map an absolute path to an abstract path for storage.
+        @returns the path, which must be freed, or nullptr
+     */
+    char* abstract_path (const char* path) const {
+        return data != nullptr ? data->abstract_path (data->handle, path) : nullptr;
+    }
+
+    /** Map a stored abstract path to an absolute path.
+        @returns the path, which must be freed, or nullptr
+     */
+    char* absolute_path (const char* path) const {
+        return data != nullptr ? data->absolute_path (data->handle, path) : nullptr;
+    }
+};
+
+#ifdef LV2_STATE__freePath
+/** LV2_State_Free_Path wrapper
+    @ingroup state
+    @headerfile lvtk/ext/state.hpp
+ */
+struct StateFreePath final : FeatureData<LV2_State_Free_Path> {
+    StateFreePath() : FeatureData (LV2_STATE__freePath) {}
+
+    /** Free a path returned by the host. Uses free() if the host didn't
+        provide the feature.
+     */
+    void operator() (char* path) const {
+        if (data != nullptr)
+            data->free_path (data->handle, path);
+        else
+            std::free (path);
+    }
+};
+#endif
+
+/** A state value passed by reference.
+    Used by blob properties so large values are stored without copying.
+    @ingroup state
+    @headerfile lvtk/ext/state.hpp
+ */
+struct StateBlob {
+    const void* data = nullptr;
+    size_t size = 0;
+};
+
+/** Moves state decoded on another thread into a running instance.
+
+    `post` is called from `restore` on a non-realtime thread, `apply` from
+    the audio thread at a block boundary.  The object `apply` replaces is
+    either handed to a callback, such as Worker::retire, or parked and
+    deleted by the next non-realtime call to `post` or `collect`.
+
+    Owns the current object, which is deleted with the exchange.
+
+    @ingroup state
+    @headerfile lvtk/ext/state.hpp
+ */
+template <class T>
+class StateExchange final {
+public:
+    StateExchange() = default;
+    explicit StateExchange (T* initial) : current (initial) {}
+
+    ~StateExchange() {
+        delete pending.load();
+        delete retired.load();
+        delete current;
+    }
+
+    /** @returns the current object. Audio thread only. */
+    T* get() const noexcept { return current; }
+
+    /** Stage a new object. Not realtime safe.
+
+        If an earlier object hasn't been applied yet, it is replaced and
+        deleted.  Also deletes anything parked by `apply`.
+
+        @param next The new object. The exchange takes ownership.
+     */
+    void post (T* next) {
+        collect();
+        delete pending.exchange (next, std::memory_order_acq_rel);
+    }
+
+    /** Delete the object parked by `apply`, if any. Not realtime safe. */
+    void collect() {
+        delete retired.exchange (nullptr, std::memory_order_acq_rel);
+    }
+
+    /** @returns true if an object is waiting to be applied */
+    bool has_pending() const noexcept { return pending.load (std::memory_order_acquire) != nullptr; }
+
+    /** Swap in the pending object. Call from the audio thread.
+
+        The old object is parked for deletion off the audio thread.  If
+        the last one hasn't been collected yet the swap waits for a
+        later block.
+
+        @returns true if a new object was applied
+     */
+    bool apply() noexcept {
+        if (retired.load (std::memory_order_acquire) != nullptr || ! has_pending())
+            return false;
+        T* next = pending.exchange (nullptr, std::memory_order_acq_rel);
+        if (next == nullptr)
+            return false;
+        retired.store (current, std::memory_order_release);
+        current = next;
+        return true;
+    }
+
+    /** Swap in the pending object and pass the old one to `retire`.
+
+        @param retire   Callable as `void (T*)`. Takes ownership of the old
+                        object, which may be nullptr.
+        @returns true if a new object was applied
+     */
+    template <class Retire>
+    bool apply (Retire&& retire) {
+        if (! has_pending())
+            return false;
+        T* next = pending.exchange (nullptr, std::memory_order_acq_rel);
+        if (next == nullptr)
+            return false;
+        T* old = current;
+        current = next;
+        retire (old);
+        return true;
+    }
+
+private:
+    T* current = nullptr;
+    std::atomic<T*> pending { nullptr };
+    std::atomic<T*> retired { nullptr };
+
+    StateExchange (const StateExchange&) = delete;
+    StateExchange& operator= (const StateExchange&) = delete;
+};
+
+namespace detail {
+/** Atom type and body of a C++ type usable as a state property */
+template <class T>
+struct StateType;
+
+template <>
+struct StateType<float> {
+    using body = float;
+    static constexpr const char* uri = LV2_ATOM__Float;
+};
+
+template <>
+struct StateType<double> {
+    using body = double;
+    static constexpr const char* uri = LV2_ATOM__Double;
+};
+
+template <>
+struct StateType<int32_t> {
+    using body = int32_t;
+    static constexpr const char* uri = LV2_ATOM__Int;
+};
+
+template <>
+struct StateType<int64_t> {
+    using body = int64_t;
+    static constexpr const char* uri = LV2_ATOM__Long;
+};
+
+template <>
+struct StateType<bool> {
+    using body = int32_t;
+    static constexpr const char* uri = LV2_ATOM__Bool;
+};
+
+/** Compressed values start with this header, then the value's type URI
+    and then an LZ4 block.  Integers are little endian.
+ */
+struct CompressedHeader {
+    static constexpr uint8_t magic[4] = { 'l', 'v', 'z', '1' };
+    static constexpr size_t size = 16;
+
+    uint64_t raw_size = 0;
+    uint32_t type_size = 0;
+
+    void write (uint8_t* dst) const noexcept {
+        std::memcpy (dst, magic, 4);
+        for (int i = 0; i < 8; ++i)
+            dst[4 + i] = (uint8_t) (raw_size >> (8 * i));
+        for (int i = 0; i < 4; ++i)
+            dst[12 + i] = (uint8_t) (type_size >> (8 * i));
+    }
+
+    bool read (const uint8_t* src, size_t length) noexcept {
+        if (length < size || std::memcmp (src, magic, 4) != 0)
+            return false;
+        raw_size = 0;
+        type_size = 0;
+        for (int i = 0; i < 8; ++i)
+            raw_size |= (uint64_t) src[4 + i] << (8 * i);
+        for (int i = 0; i < 4; ++i)
+            type_size |= (uint32_t) src[12 + i] << (8 * i);
+        return length >= size + type_size;
+    }
+};
+} // namespace detail
+
 /** Adds LV2 State support to your plugin instance.
     @ingroup state
     @headerfile lvtk/ext/state.hpp
@@ -102,9 +435,16 @@ private:
 template <class I>
 struct State : Extension<I> {
     /** @private */
-    State (const FeatureList&) {}
+    State (const FeatureList& features) {
+        for (const auto& f : features) {
+            state_map.set (f);
+            state_unmap.set (f);
+        }
+    }
 
     /** Called by the host when saving state.
+
+        The default implementation saves registered properties.
      
         @param store    Store function object to write keys/values
         @param flags    State flags to check
@@ -112,10 +452,12 @@ struct State : Extension<I> {
     */
     StateStatus save (StateStore& store,
                       uint32_t flags, const FeatureList& features) {
-        return LV2_STATE_SUCCESS;
+        return save_properties (store, features);
     }
 
     /** Called by the host when restoring state.
+
+        The default implementation restores registered properties.
      
         @param retrieve Retrieve function object to get keys/values
         @param flags    State flags to check
@@ -124,7 +466,396 @@ struct State : Extension<I> {
     StateStatus restore (StateRetrieve& retrieve,
                          uint32_t flags,
                          const FeatureList& features) {
-        return LV2_STATE_SUCCESS;
+        return restore_properties (retrieve);
+    }
+
+    /** Register a member as a state property.
+
+        `T` may be float, double, int32_t, int64_t, bool or std::string.
+
+        @param uri      Key URI
+        @param member   The member holding the value
+        @param flags    Flags passed to the store function
+        @returns the mapped key
+     */
+    template <class T>
+    uint32_t add_state_property (const std::string& uri, T I::*member,
+                                 uint32_t flags = LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE) {
+        return add_state_accessor<T> (
+            uri,
+            [member] (const I& self) -> const T& { return self.*member; },
+            [member] (I& self, const T& value) { self.*member = value; },
+            flags);
+    }
+
+    /** Register a state property with a getter and setter.
+
+        @param uri      Key URI
+        @param get      Callable as `T (const I&)`
+        @param set      Callable as `void (I&, const T&)`
+        @param flags    Flags passed to the store function
+        @returns the mapped key
+     */
+    template <class T, class Get, class Set>
+    uint32_t add_state_accessor (const std::string& uri, Get&& get, Set&& set,
+                                 uint32_t flags = LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE) {
+        auto& p = properties.emplace_back();
+        advance ([&p] (uint64_t g) { p.changed.store (g, std::memory_order_relaxed); });
+        p.key = state_map (uri);
+        p.flags = flags;
+
+        if constexpr (std::is_same<T, std::string>::value) {
+            p.type = state_map (LV2_ATOM__String);
+            p.save = [get] (const I& self, const StateStore& store, const Property& p) {
+                const std::string& value = get (self);
+                return store (p.key, value.c_str(), value.size() + 1, p.type, p.flags);
+            };
+            p.restore = [set] (I& self, const void* data, size_t size) {
+                const auto* str = static_cast<const char*> (data);
+                set (self, std::string (str, strnlen (str, size)));
+                return true;
+            };
+        } else {
+            using body_type = typename detail::StateType<T>::body;
+            p.type = state_map (detail::StateType<T>::uri);
+            p.save = [get] (const I& self, const StateStore& store, const Property& p) {
+                const auto body = static_cast<body_type> (get (self));
+                return store (p.key, &body, sizeof (body), p.type, p.flags);
+            };
+            p.restore = [set] (I& self, const void* data, size_t size) {
+                if (size != sizeof (body_type))
+                    return false;
+                body_type body;
+                std::memcpy (&body, data, sizeof (body));
+                set (self, static_cast<T> (body));
+                return true;
+            };
+        }
+
+        return p.key;
+    }
+
+    /** Register a vector member as a blob property.
+
+        The vector's memory is handed to the host directly when saving.
+
+        @param uri      Key URI
+        @param type_uri Atom type URI of the value, e.g. LV2_ATOM__Chunk
+        @param member   The member holding the value
+        @param flags    Flags passed to the store function
+        @returns the mapped key
+     */
+    template <class T>
+    uint32_t add_state_blob (const std::string& uri, const std::string& type_uri,
+                             std::vector<T> I::*member,
+                             uint32_t flags = LV2_STATE_IS_POD) {
+        static_assert (std::is_trivially_copyable<T>::value,
+                       "blob elements must be trivially copyable");
+        return add_state_blob (
+            uri, type_uri,
+            [member] (const I& self) {
+                const auto& v = self.*member;
+                return StateBlob { v.data(), v.size() * sizeof (T) };
+            },
+            [member] (I& self, StateBlob blob) {
+                if (blob.size % sizeof (T) != 0)
+                    return false;
+                auto& v = self.*member;
+                v.resize (blob.size / sizeof (T));
+                if (blob.size > 0)
+                    std::memcpy (v.data(), blob.data, blob.size);
+                return true;
+            },
+            flags);
+    }
+
+    /** Register a blob property with a getter and setter.
+
+        @param uri      Key URI
+        @param type_uri Atom type URI of the value
+        @param get      Callable as `StateBlob (const I&)`
+        @param set      Callable as `bool (I&, StateBlob)`. Return false to
+                        reject the value.
+        @param flags    Flags passed to the store function
+        @returns the mapped key
+     */
+    template <class Get, class Set>
+    uint32_t add_state_blob (const std::string& uri, const std::string& type_uri,
+                             Get&& get, Set&& set,
+                             uint32_t flags = LV2_STATE_IS_POD) {
+        auto& p = properties.emplace_back();
+        advance ([&p] (uint64_t g) { p.changed.store (g, std::memory_order_relaxed); });
+        p.key = state_map (uri);
+        p.type = state_map (type_uri);
+        p.flags = flags;
+        p.save = [get] (const I& self, const StateStore& store, const Property& p) {
+            const StateBlob blob = get (self);
+            return store (p.key, blob.data, blob.size, p.type, p.flags);
+        };
+        p.restore = [set] (I& self, const void* data, size_t size) {
+            return set (self, StateBlob { data, size });
+        };
+        return p.key;
+    }
+
+    /** Mark a registered property as changed.
+
+        Doesn't allocate or lock, so may be called from the audio thread.
+
+        @param key  Key returned when the property was registered
+     */
+    void state_changed (uint32_t key) noexcept {
+        advance ([this, key] (uint64_t g) {
+            for (auto& p : properties)
+                if (p.key == key)
+                    p.changed.store (g, std::memory_order_relaxed);
+        });
+    }
+
+    /** Mark every registered property as changed. */
+    void state_changed() noexcept {
+        advance ([this] (uint64_t g) {
+            for (auto& p : properties)
+                p.changed.store (g, std::memory_order_relaxed);
+        });
+    }
+
+    /** @returns the current state generation. Increases on every change. */
+    uint64_t state_generation() const noexcept { return generation.load(); }
+
+    /** Compress large values.
+
+        POD values of at least `threshold` bytes are stored compressed if
+        that makes them smaller.  Applies to registered properties and to
+        `store_value`.
+
+        @param threshold    Minimum size in bytes. Zero disables compression.
+     */
+    void set_state_compression (size_t threshold) noexcept { compress_threshold = threshold; }
+
+    /** Store a value, compressing it if enabled and large enough.
+        @see set_state_compression
+     */
+    StateStatus store_value (const StateStore& store, uint32_t key, const void* value,
+                             size_t size, uint32_t type, uint32_t flags) const {
+        if (compress_threshold == 0 || size < compress_threshold
+            || (flags & LV2_STATE_IS_POD) == 0 || ! state_map || ! state_unmap)
+            return store (key, value, size, type, flags);
+
+        const auto type_uri = state_unmap (type);
+        detail::CompressedHeader header;
+        header.raw_size = size;
+        header.type_size = (uint32_t) type_uri.size() + 1;
+
+        const size_t prefix = detail::CompressedHeader::size + header.type_size;
+        compress_buffer.resize (prefix + lz4::compress_bound (size));
+        header.write (compress_buffer.data());
+        std::memcpy (compress_buffer.data() + detail::CompressedHeader::size,
+                     type_uri.c_str(), header.type_size);
+
+        const size_t packed = lz4::compress (value, size, compress_buffer.data() + prefix,
+                                             compress_buffer.size() - prefix);
+        if (packed == 0 || prefix + packed >= size)
+            return store (key, value, size, type, flags);
+
+        return store (key, compress_buffer.data(), prefix + packed,
+                      state_map (LVTK_STATE__Compressed), flags);
+    }
+
+    /** Retrieve a value, decompressing it if needed.
+
+        Same as calling `retrieve` except compressed values are expanded
+        and reported with their original type.  The returned data is valid
+        until the next call.
+
+        @returns the value, or nullptr if missing or corrupt
+     */
+    const void* retrieve_value (const StateRetrieve& retrieve, uint32_t key,
+                                size_t* size = nullptr, uint32_t* type = nullptr,
+                                uint32_t* flags = nullptr) {
+        size_t stored_size = 0;
+        uint32_t stored_type = 0, stored_flags = 0;
+        const void* data = retrieve (key, &stored_size, &stored_type, &stored_flags);
+        if (data != nullptr && stored_type != 0 && stored_type == state_map (LVTK_STATE__Compressed)) {
+            const auto* bytes = static_cast<const uint8_t*> (data);
+            detail::CompressedHeader header;
+            if (! header.read (bytes, stored_size) || header.type_size == 0
+                || bytes[detail::CompressedHeader::size + header.type_size - 1] != '\0')
+                return nullptr;
+
+            const auto* type_uri = (const char*) bytes + detail::CompressedHeader::size;
+            const size_t prefix = detail::CompressedHeader::size + header.type_size;
+            // LZ4 can't expand more than 255 times, anything larger is corrupt
+            if (header.raw_size > (uint64_t) (stored_size - prefix) * 255)
+                return nullptr;
+            decompress_buffer.resize ((size_t) header.raw_size);
+            if (header.raw_size > 0
+                && header.raw_size != lz4::decompress (bytes + prefix, stored_size - prefix,
+                                                       decompress_buffer.data(), decompress_buffer.size()))
+                return nullptr;
+
+            data = decompress_buffer.data();
+            stored_size = decompress_buffer.size();
+            stored_type = state_map (type_uri);
+        }
+
+        if (size != nullptr)
+            *size = stored_size;
+        if (type != nullptr)
+            *type = stored_type;
+        if (flags != nullptr)
+            *flags = stored_flags;
+        return data;
+    }
+
+    /** Store every registered property.
+        @returns the first failed status, or LV2_STATE_SUCCESS
+     */
+    StateStatus save_properties (const StateStore& store) const {
+        return save_properties_since (store, 0);
+    }
+
+    /** Store registered properties, only those changed since a previous
+        save if the host passed a @ref StateSince feature.
+        @returns the first failed status, or LV2_STATE_SUCCESS
+     */
+    StateStatus save_properties (const StateStore& store, const FeatureList& features) const {
+        StateSince* since = nullptr;
+        for (const auto& f : features) {
+            if (f == LVTK_STATE__since) {
+                since = static_cast<StateSince*> (f.data);
+                break;
+            }
+        }
+
+        if (since == nullptr)
+            return save_properties_since (store, 0);
+
+        // read first so changes made while saving are picked up next time.
+        // Properties are stamped before the generation moves, so none
+        // changed up to this one can be missed below.
+        since->generation = generation.load (std::memory_order_acquire);
+        since->incremental = true;
+        return save_properties_since (store, since->since);
+    }
+
+    /** Store registered properties changed after a generation.
+        @returns the first failed status, or LV2_STATE_SUCCESS
+     */
+    StateStatus save_properties_since (const StateStore& store, uint64_t since) const {
+        const auto& self = static_cast<const I&> (*this);
+        CompressingStore context { this, &store };
+        const StateStore compressing (_store_value, &context);
+
+        StateStatus status = LV2_STATE_SUCCESS;
+        for (const auto& p : properties) {
+            if (p.key == 0 || p.type == 0)
+                continue;
+            if (since > 0 && p.changed.load (std::memory_order_acquire) <= since)
+                continue;
+            const auto s = p.save (self, compress_threshold > 0 ? compressing : store, p);
+            if (status == LV2_STATE_SUCCESS)
+                status = s;
+        }
+        return status;
+    }
+
+    /** Retrieve every registered property.
+
+        Missing keys are left untouched.  Values with the wrong type or
+        size are skipped.
+
+        @returns LV2_STATE_ERR_BAD_TYPE if any value was skipped
+     */
+    StateStatus restore_properties (const StateRetrieve& retrieve) {
+        auto& self = static_cast<I&> (*this);
+        StateStatus status = LV2_STATE_SUCCESS;
+        for (const auto& p : properties) {
+            if (p.key == 0)
+                continue;
+
+            size_t size = 0;
+            uint32_t type = 0, flags = 0;
+            const void* data = retrieve_value (retrieve, p.key, &size, &type, &flags);
+            if (data == nullptr)
+                continue;
+
+            if (type != p.type || ! p.restore (self, data, size))
+                status = LV2_STATE_ERR_BAD_TYPE;
+            else
+                state_changed (p.key);
+        }
+        return status;
+    }
+
+    /** Write a value to a file and store its path.
+
+        The file is created with the host's makePath feature and its
+        abstract path is stored as an atom:Path, so the value itself never
+        passes through the host.  Call from `save`.
+
+        @param store    The store function
+        @param features Features passed to `save`
+        @param key      Key to store the path under
+        @param filename File name relative to the state directory
+        @param data     Bytes to write
+        @param size     Number of bytes
+        @returns LV2_STATE_ERR_NO_FEATURE if makePath or mapPath is missing
+     */
+    StateStatus save_file (const StateStore& store, const FeatureList& features,
+                           uint32_t key, const char* filename,
+                           const void* data, size_t size) const {
+        StateMakePath make_path;
+        StateMapPath map_path;
+        for (const auto& f : features) {
+            make_path.set (f);
+            map_path.set (f);
+        }
+        if (! make_path || ! map_path)
+            return LV2_STATE_ERR_NO_FEATURE;
+
+        StateStatus status = LV2_STATE_ERR_UNKNOWN;
+        char* path = make_path (filename);
+        if (FILE* file = path != nullptr ? std::fopen (path, "wb") : nullptr) {
+            const bool written = size == 0 || std::fwrite (data, 1, size, file) == size;
+            if (std::fclose (file) == 0 && written) {
+                char* apath = map_path.abstract_path (path);
+                if (apath != nullptr)
+                    status = store (key, apath, std::strlen (apath) + 1, state_map (LV2_ATOM__Path),
+                                    LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE);
+                free_path (features, apath);
+            }
+        }
+
+        free_path (features, path);
+        return status;
+    }
+
+    /** Map a file stored with `save_file`.  Call from `restore`.
+
+        @param retrieve The retrieve function
+        @param features Features passed to `restore`
+        @param key      Key the path was stored under
+        @returns the mapped file, which isn't open on failure
+     */
+    MappedFile restore_file (const StateRetrieve& retrieve, const FeatureList& features,
+                             uint32_t key) const {
+        StateMapPath map_path;
+        for (const auto& f : features)
+            if (map_path.set (f))
+                break;
+
+        size_t size = 0;
+        uint32_t type = 0, flags = 0;
+        const auto* apath = static_cast<const char*> (retrieve (key, &size, &type, &flags));
+        if (apath == nullptr || type != state_map (LV2_ATOM__Path) || ! map_path)
+            return {};
+
+        MappedFile file;
+        char* path = map_path.absolute_path (apath);
+        file.open (path);
+        free_path (features, path);
+        return file;
     }
 
 protected:
@@ -135,6 +866,64 @@ protected:
     }
 
 private:
+    struct Property {
+        uint32_t key = 0;
+        uint32_t type = 0;
+        uint32_t flags = 0;
+        std::atomic<uint64_t> changed { 0 }; // generation of the last change
+        std::function<StateStatus (const I&, const StateStore&, const Property&)> save;
+        std::function<bool (I&, const void*, size_t)> restore;
+    };
+
+    Map state_map;
+    Unmap state_unmap;
+    std::deque<Property> properties;
+    std::atomic<uint64_t> generation { 1 };
+
+    // Stamps changed properties with the next generation, then publishes
+    // it.  A save which reads a generation therefore sees every property
+    // stamped with it.  A writer which loses the race stamps again with a
+    // newer generation, so its final stamp is always one it published.
+    template <typename Stamp>
+    void advance (Stamp&& stamp) noexcept {
+        auto g = generation.load (std::memory_order_relaxed);
+        do {
+            stamp (g + 1);
+        } while (! generation.compare_exchange_weak (g, g + 1,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed));
+    }
+
+    size_t compress_threshold = 0;
+    mutable std::vector<uint8_t> compress_buffer;
+    std::vector<uint8_t> decompress_buffer;
+
+    struct CompressingStore {
+        const State* self;
+        const StateStore* store;
+    };
+
+    static LV2_State_Status _store_value (LV2_State_Handle handle, uint32_t key,
+                                          const void* value, size_t size,
+                                          uint32_t type, uint32_t flags) {
+        auto* context = static_cast<CompressingStore*> (handle);
+        return context->self->store_value (*context->store, key, value, size, type, flags);
+    }
+
+    static void free_path (const FeatureList& features, char* path) {
+        if (path == nullptr)
+            return;
+#ifdef LV2_STATE__freePath
+        StateFreePath free_fn;
+        for (const auto& f : features)
+            if (free_fn.set (f))
+                break;
+        free_fn (path);
+#else
+        std::free (path);
+#endif
+    }
+
     static LV2_State_Status _save (LV2_Handle instance,
                                    LV2_State_Store_Function store_function,
                                    LV2_State_Handle state_handle,
@@ -31,7 +31,8 @@ struct Idle : Extension<I> {
     Idle (const FeatureList&) {}
 
     /** Called repeatedly by the host to drive your UI.  Return non-zero
-        to stop receiving callbacks.
+        to stop receiving callbacks.  Deferred port events are applied
+        before each call and coalesced port writes are flushed after.
         
         @returns one by default, so you must override this to be useful.
      */
@@ -44,7 +45,13 @@ protected:
     }
 
 private:
-    static int _idle (LV2UI_Handle ui) { return (static_cast<I*> (ui))->idle(); }
+    static int _idle (LV2UI_Handle ui) {
+        auto self = static_cast<I*> (ui);
+        self->apply_port_events();
+        const int result = self->idle();
+        self->flush_writes();
+        return result;
+    }
 };
 
 } // namespace lvtk
@@ -16,10 +16,64 @@
 
 #pragma once
 
+#include <cstdint>
+#include <unordered_map>
+
 #include <lv2/ui/ui.h>
 #include <lvtk/ext/extension.hpp>
 
 namespace lvtk {
+
+/** Reference counted port subscriptions.
+
+    Each user of a port retains it while it needs events.  The host is
+    asked to subscribe when the first one does and to unsubscribe when
+    the last one releases it, so many widgets can show the same port.
+    Protocol 0 is the float protocol.
+
+    @ingroup ui
+    @headerfile lvtk/ext/ui/port_subscribe.hpp
+ */
+class PortSubscriptions final {
+public:
+    PortSubscriptions() = default;
+    explicit PortSubscriptions (const LV2UI_Port_Subscribe& ps) : port_subscribe (ps) {}
+
+    /** Add a reference, subscribing on the first one */
+    void retain (uint32_t port, uint32_t protocol = 0) {
+        if (++counts[key (port, protocol)] == 1 && port_subscribe.handle != nullptr)
+            port_subscribe.subscribe (port_subscribe.handle, port, protocol, nullptr);
+    }
+
+    /** Remove a reference, unsubscribing on the last one */
+    void release (uint32_t port, uint32_t protocol = 0) {
+        auto it = counts.find (key (port, protocol));
+        if (it == counts.end())
+            return;
+        if (--it->second == 0) {
+            counts.erase (it);
+            if (port_subscribe.handle != nullptr)
+                port_subscribe.unsubscribe (port_subscribe.handle, port, protocol, nullptr);
+        }
+    }
+
+    /** @returns the number of references to a port */
+    uint32_t references (uint32_t port, uint32_t protocol = 0) const {
+        auto it = counts.find (key (port, protocol));
+        return it != counts.end() ? it->second : 0;
+    }
+
+    /** @returns the number of ports subscribed */
+    size_t size() const noexcept { return counts.size(); }
+
+private:
+    LV2UI_Port_Subscribe port_subscribe { nullptr, nullptr, nullptr };
+    std::unordered_map<uint64_t, uint32_t> counts;
+
+    static uint64_t key (uint32_t port, uint32_t protocol) noexcept {
+        return (uint64_t) port << 32 | protocol;
+    }
+};
 /** Support for UI Port Subscribe
     @ingroup ui
     @headerfile lvtk/ext/ui/port_subscribe.hpp
@@ -31,11 +85,15 @@ struct PortSubscribe : NullExtension {
         for (const auto& f : features) {
             if (f == LV2_UI__portSubscribe) {
                 port_subscribe = *(LV2UI_Port_Subscribe*) f.data;
+                subscriptions = PortSubscriptions (port_subscribe);
                 break;
             }
         }
     }
 
+    /** Reference counted subscriptions, e.g. for @ref Main::set_port_subscriptions */
+    PortSubscriptions& port_subscriptions() noexcept { return subscriptions; }
+
     /** Subscribe to port events */
     uint32_t subscribe (uint32_t port, uint32_t protocol, const LV2_Feature* const* features) const {
         return (port_subscribe.handle != nullptr)
@@ -52,6 +110,7 @@ struct PortSubscribe : NullExtension {
 
 private:
     LV2UI_Port_Subscribe port_subscribe { nullptr, nullptr, nullptr };
+    PortSubscriptions subscriptions;
 };
 
 } // namespace lvtk
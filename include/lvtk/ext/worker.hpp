@@ -48,13 +48,100 @@
             }
         };
     @endcode
+
+    <h3>Typed Messages</h3>
+    Instead of raw bytes, a plugin can declare its messages as trivially
+    copyable structs.  Each is sent with a compact type tag, and `work` and
+    `work_response` are dispatched to an overload per type through a table
+    generated at compile time. Handlers receive a reference straight into the
+    host's buffer, so nothing is copied on the receiving end.
+    @code
+        struct LoadSample { uint32_t slot; char path[256]; };
+        struct SampleLoaded { uint32_t slot; Sample* sample; };
+
+        class Sampler : public Plugin<Sampler, Worker> {
+        public:
+            using work_messages = WorkerMessages<LoadSample, SampleLoaded>;
+
+            void run (uint32_t nframes) {
+                // ...
+                schedule (LoadSample { 0, "/path/to/kick.wav" });
+            }
+
+            WorkerStatus work (WorkerRespond& respond, const LoadSample& msg) {
+                return respond (SampleLoaded { msg.slot, load_sample (msg.path) });
+            }
+
+            WorkerStatus work_response (const SampleLoaded& msg) {
+                samples[msg.slot] = msg.sample;
+                return WORKER_SUCCESS;
+            }
+        };
+    @endcode
+
+    <h3>Latest-Wins Jobs</h3>
+    Jobs driven by a moving parameter only need the newest request
+    computed.  Give the message types a @ref WorkerTicket named `ticket`
+    and schedule with `schedule_latest`.  Requests superseded by a newer one
+    with the same key are skipped before `work` is called, and responses
+    which are out of date by the time they reach the audio thread are
+    dropped before `work_response`.
+    @code
+        struct Design { WorkerTicket ticket; float cutoff; };
+        struct Coeffs { WorkerTicket ticket; float b[3], a[3]; };
+
+        void run (uint32_t nframes) {
+            if (cutoff_changed)
+                schedule_latest (FILTER_KEY, Design { {}, *cutoff });
+        }
+
+        WorkerStatus work (WorkerRespond& respond, const Design& msg) {
+            Coeffs out { msg.ticket };
+            design_filter (msg.cutoff, out);
+            return respond (out);
+        }
+    @endcode
+
+    <h3>Object Handoff</h3>
+    Large objects are built on the worker, swapped in on the audio thread
+    with a @ref Handoff, and the object they replace is sent back to the
+    worker with `retire` to be deleted there.
+    @code
+        struct LoadIR { char path[256]; };
+        struct IRLoaded { ImpulseResponse* ir; };
+
+        WorkerStatus work (WorkerRespond& respond, const LoadIR& msg) {
+            return respond (IRLoaded { new ImpulseResponse (msg.path) });
+        }
+
+        WorkerStatus work_response (const IRLoaded& msg) {
+            return retire (ir.swap (msg.ir));
+        }
+
+        lvtk::Handoff<ImpulseResponse> ir;
+    @endcode
 */
 
 #pragma once
 
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
 #include <lv2/worker/worker.h>
 #include <lvtk/ext/extension.hpp>
 
+#ifndef LVTK_WORKER_MAX_KEYS
+    /** Number of distinct keys available to Worker::schedule_latest */
+    #define LVTK_WORKER_MAX_KEYS 32
+#endif
+
+#ifndef LVTK_WORKER_MAX_RETIRED
+    /** Number of retired objects Worker::retire can hold while the host's
+        queue is full */
+    #define LVTK_WORKER_MAX_RETIRED 32
+#endif
+
 namespace lvtk {
 
 /** Alias of LV2_Worker_Status
@@ -63,6 +150,135 @@ namespace lvtk {
 */
 using WorkerStatus = LV2_Worker_Status;
 
+/** Identifies one request of a latest-wins job.
+
+    Add a member of this type named `ticket` to typed messages which are
+    scheduled with Worker::schedule_latest, and copy it into the response.
+
+    @ingroup worker
+    @headerfile lvtk/ext/worker.hpp
+ */
+struct WorkerTicket {
+    uint32_t key = 0;        /**< The job key */
+    uint32_t generation = 0; /**< Request number for the key, zero if none */
+};
+
+/** @private */
+namespace detail {
+/** The address of `id` uniquely identifies T */
+template <class T>
+struct MessageKey {
+    static constexpr char id = 0;
+};
+
+/** Type keys of a message list, in tag order */
+struct MessageKeys {
+    const void* const* keys;
+    uint32_t size;
+};
+
+/** Sent by Worker::retire to delete an object on the worker thread */
+struct RetirePacket {
+    static constexpr uint32_t magic = 0x6b74766c;
+    static constexpr char id = 0;
+
+    uint32_t tag;
+    const void* key;
+    void (*destroy) (void*);
+    void* object;
+
+    static bool is_retire (uint32_t size, const void* data) noexcept {
+        if (size != sizeof (RetirePacket) || data == nullptr)
+            return false;
+        const auto* packet = static_cast<const RetirePacket*> (data);
+        return packet->tag == magic && packet->key == &id;
+    }
+};
+
+template <class T>
+static void destroy_object (void* object) {
+    delete static_cast<T*> (object);
+}
+} // namespace detail
+
+/** Holds an object which is replaced from the audio thread.
+
+    The worker builds a replacement and sends the pointer in a response.
+    In `work_response` the audio thread calls `swap`, and passes the old
+    object to Worker::retire so it is deleted on the worker thread.
+
+    Owns the current object, which is deleted with the Handoff.
+
+    @ingroup worker
+    @headerfile lvtk/ext/worker.hpp
+ */
+template <class T>
+class Handoff final {
+public:
+    Handoff() = default;
+    explicit Handoff (T* initial) : current (initial) {}
+    ~Handoff() { delete current.load(); }
+
+    /** @returns the current object, or nullptr */
+    T* get() const noexcept { return current.load (std::memory_order_acquire); }
+
+    /** Install a new object.
+        @returns the previous object, which the caller now owns
+     */
+    T* swap (T* next) noexcept { return current.exchange (next, std::memory_order_acq_rel); }
+
+    T* operator->() const noexcept { return get(); }
+    operator bool() const noexcept { return get() != nullptr; }
+
+private:
+    std::atomic<T*> current { nullptr };
+    Handoff (const Handoff&) = delete;
+    Handoff& operator= (const Handoff&) = delete;
+};
+
+/** A typed worker message as written to the host.
+    @ingroup worker
+    @headerfile lvtk/ext/worker.hpp
+ */
+template <class T>
+struct WorkerPacket {
+    uint32_t tag; /**< Index of T in the plugin's `work_messages` */
+    T body;       /**< The message */
+};
+
+/** List of message types a plugin exchanges with its worker.
+
+    Declare this as `work_messages` in your plugin to enable typed
+    scheduling and dispatch. The tag of each type is its index in the list.
+
+    @ingroup worker
+    @headerfile lvtk/ext/worker.hpp
+ */
+template <class... T>
+struct WorkerMessages {
+    static_assert (sizeof...(T) > 0, "WorkerMessages needs at least one type");
+    static_assert ((std::is_trivially_copyable<T>::value && ...),
+                   "Worker messages must be trivially copyable");
+
+    /** Number of message types */
+    static constexpr uint32_t size = sizeof...(T);
+
+    /** @returns the tag of M, or `size` if M isn't in the list */
+    template <class M>
+    static constexpr uint32_t tag() {
+        uint32_t i = 0, result = size;
+        ((std::is_same<M, T>::value ? (result = i, ++i) : ++i), ...);
+        return result;
+    }
+
+    /** @private */
+    static const detail::MessageKeys& keys() {
+        static const void* const k[] = { &detail::MessageKey<T>::id... };
+        static const detail::MessageKeys mk { k, size };
+        return mk;
+    }
+};
+
 /** Worker reponse function
 
     This wraps an LV2_Worker_Respond_Function.  It is passed to
@@ -74,9 +290,11 @@ using WorkerStatus = LV2_Worker_Status;
 struct WorkerRespond {
     WorkerRespond (LV2_Handle instance,
                    LV2_Worker_Respond_Function respond_function,
-                   LV2_Worker_Respond_Handle handle)
+                   LV2_Worker_Respond_Handle handle,
+                   const detail::MessageKeys* message_keys = nullptr)
         : p_handle (handle),
-          f_respond (respond_function) {}
+          f_respond (respond_function),
+          p_keys (message_keys) {}
 
     /** Execute the worker respond function.
         @param size
@@ -87,10 +305,123 @@ struct WorkerRespond {
         return f_respond (p_handle, size, data);
     }
 
+    /** Send a typed response.  The type must be listed in the plugin's
+        `work_messages`.
+        @param msg  The message to send
+        @return WORKER_SUCCESS on success
+     */
+    template <class T>
+    WorkerStatus operator() (const T& msg) const {
+        if (p_keys == nullptr)
+            return LV2_WORKER_ERR_UNKNOWN;
+        for (uint32_t tag = 0; tag < p_keys->size; ++tag) {
+            if (p_keys->keys[tag] == &detail::MessageKey<T>::id) {
+                const WorkerPacket<T> packet { tag, msg };
+                return f_respond (p_handle, sizeof (packet), &packet);
+            }
+        }
+        return LV2_WORKER_ERR_UNKNOWN;
+    }
+
 private:
     LV2_Worker_Respond_Handle p_handle;
     LV2_Worker_Respond_Function f_respond;
+    const detail::MessageKeys* p_keys;
+};
+
+/** @private */
+namespace detail {
+template <class I, class = void>
+struct has_work_messages : std::false_type {};
+
+template <class I>
+struct has_work_messages<I, std::void_t<typename I::work_messages>> : std::true_type {};
+
+template <class I, class T, class = void>
+struct has_typed_work : std::false_type {};
+
+template <class I, class T>
+struct has_typed_work<I, T, std::void_t<decltype (std::declval<I&>().work (std::declval<WorkerRespond&>(), std::declval<const T&>()))>>
+    : std::true_type {};
+
+template <class I, class T, class = void>
+struct has_typed_work_response : std::false_type {};
+
+template <class I, class T>
+struct has_typed_work_response<I, T, std::void_t<decltype (std::declval<I&>().work_response (std::declval<const T&>()))>>
+    : std::true_type {};
+
+template <class T, class = void>
+struct has_ticket : std::false_type {};
+
+template <class T>
+struct has_ticket<T, std::enable_if_t<std::is_same<decltype (T::ticket), WorkerTicket>::value>>
+    : std::true_type {};
+
+template <class I, class List>
+struct WorkerDispatch;
+
+/** Jump tables which route tagged packets to typed handlers */
+template <class I, class... T>
+struct WorkerDispatch<I, WorkerMessages<T...>> {
+    using work_function = WorkerStatus (*) (I&, WorkerRespond&, const void*);
+    using response_function = WorkerStatus (*) (I&, const void*);
+
+    template <class M>
+    static WorkerStatus work_one (I& self, WorkerRespond& respond, const void* data) {
+        const auto& body = static_cast<const WorkerPacket<M>*> (data)->body;
+        if constexpr (has_ticket<M>::value) {
+            if (! self.is_latest (body.ticket)) {
+                self.coalesced.fetch_add (1, std::memory_order_relaxed);
+                return LV2_WORKER_SUCCESS;
+            }
+        }
+
+        if constexpr (has_typed_work<I, M>::value)
+            return self.work (respond, body);
+        else
+            return LV2_WORKER_ERR_UNKNOWN;
+    }
+
+    template <class M>
+    static WorkerStatus response_one (I& self, const void* data) {
+        const auto& body = static_cast<const WorkerPacket<M>*> (data)->body;
+        if constexpr (has_ticket<M>::value) {
+            if (! self.is_latest (body.ticket)) {
+                self.stale.fetch_add (1, std::memory_order_relaxed);
+                return LV2_WORKER_SUCCESS;
+            }
+        }
+
+        if constexpr (has_typed_work_response<I, M>::value)
+            return self.work_response (body);
+        else
+            return LV2_WORKER_ERR_UNKNOWN;
+    }
+
+    static bool valid (uint32_t size, const void* data) {
+        static constexpr uint32_t sizes[] = { (uint32_t) sizeof (WorkerPacket<T>)... };
+        if (data == nullptr || size < sizeof (uint32_t))
+            return false;
+        const auto tag = *static_cast<const uint32_t*> (data);
+        return tag < sizeof...(T) && sizes[tag] == size;
+    }
+
+    static WorkerStatus work (I& self, WorkerRespond& respond, uint32_t size, const void* data) {
+        static constexpr work_function table[] = { &work_one<T>... };
+        if (! valid (size, data))
+            return LV2_WORKER_ERR_UNKNOWN;
+        return table[*static_cast<const uint32_t*> (data)](self, respond, data);
+    }
+
+    static WorkerStatus work_response (I& self, uint32_t size, const void* data) {
+        static constexpr response_function table[] = { &response_one<T>... };
+        if (! valid (size, data))
+            return LV2_WORKER_ERR_UNKNOWN;
+        return table[*static_cast<const uint32_t*> (data)](self, data);
+    }
 };
+} // namespace detail
 
 /** Schedule jobs with the host.
 
@@ -131,6 +462,12 @@ struct Worker : Extension<I> {
                 break;
     }
 
+    /** @private */
+    ~Worker() {
+        for (uint32_t i = 0; i < num_retired; ++i)
+            retired[i].destroy (retired[i].object);
+    }
+
     /** Perform work as requested by schedule_work
      
         @param respond  Function to send responses with
@@ -165,6 +502,96 @@ struct Worker : Extension<I> {
      */
     WorkerSchedule schedule_work;
 
+    /** Schedule a typed message. T must be listed in your instance's
+        `work_messages`.  The message is dispatched to the matching
+        `work (WorkerRespond&, const T&)` overload.
+
+        @param msg  The message to send
+     */
+    template <class T>
+    WorkerStatus schedule (const T& msg) const {
+        using messages = typename I::work_messages;
+        constexpr uint32_t tag = messages::template tag<T>();
+        static_assert (tag < messages::size, "Type is not listed in work_messages");
+        const WorkerPacket<T> packet { tag, msg };
+        return schedule_work (sizeof (packet), &packet);
+    }
+
+    /** Schedule a typed message where only the newest request per key
+        matters.  T must have a WorkerTicket member named `ticket`, which is
+        filled in here.  Older requests with the same key still waiting on
+        the worker are skipped, and their responses are dropped.
+
+        Call from the audio thread only.
+
+        @param key  Job key, less than LVTK_WORKER_MAX_KEYS
+        @param msg  The message to send
+     */
+    template <class T>
+    WorkerStatus schedule_latest (uint32_t key, const T& msg) {
+        static_assert (detail::has_ticket<T>::value,
+                       "Message needs a WorkerTicket member named 'ticket'");
+        using messages = typename I::work_messages;
+        constexpr uint32_t tag = messages::template tag<T>();
+        static_assert (tag < messages::size, "Type is not listed in work_messages");
+        if (key >= LVTK_WORKER_MAX_KEYS)
+            return LV2_WORKER_ERR_UNKNOWN;
+
+        // only the audio thread writes latest, and only once the request
+        // is queued, so a failed schedule doesn't make the queued one stale
+        WorkerPacket<T> packet { tag, msg };
+        packet.body.ticket.key = key;
+        packet.body.ticket.generation = latest[key].load (std::memory_order_relaxed) + 1;
+        const auto status = schedule_work (sizeof (packet), &packet);
+        if (status == LV2_WORKER_SUCCESS)
+            latest[key].store (packet.body.ticket.generation, std::memory_order_release);
+        return status;
+    }
+
+    /** @returns false if a newer request was scheduled for the ticket's key */
+    bool is_latest (const WorkerTicket& ticket) const noexcept {
+        if (ticket.generation == 0 || ticket.key >= LVTK_WORKER_MAX_KEYS)
+            return true;
+        // a request may run before schedule_latest returns, so it counts
+        // as latest until a newer one is stored
+        const auto newest = latest[ticket.key].load (std::memory_order_acquire);
+        return (int32_t) (ticket.generation - newest) >= 0;
+    }
+
+    /** Delete an object on the worker thread.
+
+        Call from the audio thread, typically with the result of
+        Handoff::swap. If the host's queue is full the object is held and
+        sent again on the next call or at the end of the run cycle. It is
+        never deleted on the audio thread.
+
+        @param object   The object to delete. May be nullptr.
+        @returns WORKER_SUCCESS if the object was sent or held for later
+     */
+    template <class T>
+    WorkerStatus retire (T* object) noexcept {
+        flush_retired();
+        if (object == nullptr)
+            return LV2_WORKER_SUCCESS;
+        if (send_retired (&detail::destroy_object<T>, object))
+            return LV2_WORKER_SUCCESS;
+        if (num_retired < LVTK_WORKER_MAX_RETIRED) {
+            retired[num_retired++] = { &detail::destroy_object<T>, object };
+            return LV2_WORKER_SUCCESS;
+        }
+        ++leaked;
+        return LV2_WORKER_ERR_NO_SPACE;
+    }
+
+    /** @returns the number of retired objects which couldn't be sent or held */
+    uint64_t leaked_objects() const noexcept { return leaked; }
+
+    /** @returns the number of requests skipped because a newer one was pending */
+    uint64_t coalesced_jobs() const noexcept { return coalesced.load(); }
+
+    /** @returns the number of responses dropped because they were out of date */
+    uint64_t dropped_responses() const noexcept { return stale.load(); }
+
 protected:
     /** @private */
     static void map_extension_data (ExtensionMap& dmap) {
@@ -173,26 +600,79 @@ protected:
     }
 
 private:
+    template <class, class>
+    friend struct detail::WorkerDispatch;
+
+    std::atomic<uint32_t> latest[LVTK_WORKER_MAX_KEYS] {};
+    std::atomic<uint64_t> coalesced { 0 };
+    std::atomic<uint64_t> stale { 0 };
+
+    struct Retired {
+        void (*destroy) (void*);
+        void* object;
+    };
+    Retired retired[LVTK_WORKER_MAX_RETIRED] {};
+    uint32_t num_retired = 0;
+    uint64_t leaked = 0;
+
+    bool send_retired (void (*destroy) (void*), void* object) noexcept {
+        const detail::RetirePacket packet { detail::RetirePacket::magic,
+                                            &detail::RetirePacket::id,
+                                            destroy,
+                                            object };
+        return LV2_WORKER_SUCCESS == schedule_work (sizeof (packet), &packet);
+    }
+
+    void flush_retired() noexcept {
+        while (num_retired > 0) {
+            const auto& r = retired[num_retired - 1];
+            if (! send_retired (r.destroy, r.object))
+                break;
+            --num_retired;
+        }
+    }
+
     /** @internal */
     static LV2_Worker_Status _work (LV2_Handle instance,
                                     LV2_Worker_Respond_Function respond,
                                     LV2_Worker_Respond_Handle handle,
                                     uint32_t size,
                                     const void* data) {
-        WorkerRespond wrsp (instance, respond, handle);
-        return (LV2_Worker_Status) (static_cast<I*> (instance))->work (wrsp, size, data);
+        auto* const plugin = static_cast<I*> (instance);
+        if (detail::RetirePacket::is_retire (size, data)) {
+            const auto* packet = static_cast<const detail::RetirePacket*> (data);
+            packet->destroy (packet->object);
+            return LV2_WORKER_SUCCESS;
+        }
+
+        if constexpr (detail::has_work_messages<I>::value) {
+            using messages = typename I::work_messages;
+            WorkerRespond wrsp (instance, respond, handle, &messages::keys());
+            return (LV2_Worker_Status) detail::WorkerDispatch<I, messages>::work (*plugin, wrsp, size, data);
+        } else {
+            WorkerRespond wrsp (instance, respond, handle);
+            return (LV2_Worker_Status) plugin->work (wrsp, size, data);
+        }
     }
 
     /** @internal */
     static LV2_Worker_Status _work_response (LV2_Handle instance,
                                              uint32_t size,
                                              const void* body) {
-        return (LV2_Worker_Status) (static_cast<I*> (instance))->work_response (size, body);
+        auto* const plugin = static_cast<I*> (instance);
+        if constexpr (detail::has_work_messages<I>::value) {
+            using messages = typename I::work_messages;
+            return (LV2_Worker_Status) detail::WorkerDispatch<I, messages>::work_response (*plugin, size, body);
+        } else {
+            return (LV2_Worker_Status) plugin->work_response (size, body);
+        }
     }
 
     /** @internal */
     static LV2_Worker_Status _end_run (LV2_Handle instance) {
-        return (LV2_Worker_Status) (static_cast<I*> (instance))->end_run();
+        auto* const plugin = static_cast<I*> (instance);
+        plugin->flush_retired();
+        return (LV2_Worker_Status) plugin->end_run();
     }
 };
 
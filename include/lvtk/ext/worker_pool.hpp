@@ -0,0 +1,246 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <lvtk/ext/worker.hpp>
+#include <lvtk/optional.hpp>
+
+namespace lvtk {
+
+/** A plugin-owned thread pool for use inside `work`.
+
+    The host runs a single worker thread per plugin, so a job which fans out
+    into many independent pieces (e.g. loading every sample of a preset)
+    would otherwise run serially.  Give your plugin a WorkerPool and call
+    `run` from `work` to spread the pieces over several threads.
+
+    Each pool thread has its own queue and steals from the others when it
+    runs dry.  The calling thread helps out while it waits.  Results are
+    always delivered on the calling thread in submission order, so the
+    responses the audio thread sees are deterministic.
+
+    @code
+        WorkerStatus work (WorkerRespond& respond, const LoadPreset& msg) {
+            return pool.run (respond, msg.num_samples, [&] (uint32_t i) {
+                return SampleLoaded { i, load_sample (msg.paths[i]) };
+            });
+        }
+    @endcode
+
+    @headerfile lvtk/ext/worker_pool.hpp
+    @ingroup worker
+ */
+class WorkerPool final {
+public:
+    /** Create a pool.
+        @param num_threads  Number of threads. Zero uses one less than the
+                            number of hardware threads, since the calling
+                            thread also runs jobs.
+     */
+    explicit WorkerPool (uint32_t num_threads = 0) {
+        if (num_threads == 0) {
+            const auto hw = std::thread::hardware_concurrency();
+            num_threads = hw > 1 ? hw - 1 : 1;
+        }
+
+        for (uint32_t i = 0; i < num_threads; ++i)
+            queues.push_back (std::make_unique<Queue>());
+        for (uint32_t i = 0; i < num_threads; ++i)
+            threads.emplace_back (&WorkerPool::process, this, i);
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> sl (lock);
+            exit_flag = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads)
+            t.join();
+    }
+
+    /** @returns the number of pool threads */
+    uint32_t size() const noexcept { return (uint32_t) threads.size(); }
+
+    /** Run jobs in parallel and deliver results in order.
+
+        `job (i)` is called for every i in [0, count) on any thread and
+        returns a result.  `deliver (i, result)` is called on the calling
+        thread in index order, as soon as result `i` and all before it are
+        ready.  Returns once every result has been delivered.
+
+        If a job or `deliver` throws, nothing after it is delivered.  The
+        first exception is rethrown once every job has finished, so no job
+        outlives the call.
+
+        @param count    Number of jobs
+        @param job      Callable as `R (uint32_t index)`
+        @param deliver  Callable as `void (uint32_t index, R& result)`
+     */
+    template <class Job, class Deliver>
+    void run (uint32_t count, Job&& job, Deliver&& deliver) {
+        using result_type = std::decay_t<std::invoke_result_t<Job&, uint32_t>>;
+        if (count == 0)
+            return;
+
+        std::vector<Optional<result_type>> results (count);
+        std::vector<std::exception_ptr> errors (count);
+        std::unique_ptr<std::atomic<bool>[]> ready (new std::atomic<bool>[count]);
+        std::mutex ready_lock;
+        std::condition_variable ready_cond;
+
+        for (uint32_t i = 0; i < count; ++i) {
+            ready[i].store (false);
+            submit (i, [&, i]() {
+                try {
+                    results[i] = job (i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+                std::lock_guard<std::mutex> rl (ready_lock);
+                ready[i].store (true);
+                ready_cond.notify_all();
+            });
+        }
+
+        // keep waiting after a failure, the jobs still reference our locals
+        std::exception_ptr error;
+        for (uint32_t i = 0; i < count; ++i) {
+            while (! ready[i].load()) {
+                if (run_one (0))
+                    continue;
+                std::unique_lock<std::mutex> rl (ready_lock);
+                ready_cond.wait (rl, [&] { return ready[i].load(); });
+            }
+
+            if (error == nullptr)
+                error = errors[i];
+            if (error != nullptr)
+                continue;
+
+            try {
+                deliver (i, *results[i]);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        // jobs notify while holding the lock, so once we hold it every job
+        // is done touching the condition and it's safe to destroy
+        {
+            std::lock_guard<std::mutex> rl (ready_lock);
+        }
+
+        if (error != nullptr)
+            std::rethrow_exception (error);
+    }
+
+    /** Run jobs in parallel and respond with each result in order.
+
+        Same as the above, except that every result is sent with the
+        typed `respond` operator. Results must be listed in your plugin's
+        `work_messages`.
+
+        @returns the first failed respond status, or WORKER_SUCCESS
+     */
+    template <class Job>
+    WorkerStatus run (WorkerRespond& respond, uint32_t count, Job&& job) {
+        WorkerStatus status = LV2_WORKER_SUCCESS;
+        run (count, std::forward<Job> (job), [&] (uint32_t, auto& result) {
+            const auto s = respond (result);
+            if (status == LV2_WORKER_SUCCESS)
+                status = s;
+        });
+        return status;
+    }
+
+private:
+    using Task = std::function<void()>;
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::atomic<uint32_t> pending { 0 }; // changed with the queue it counts
+    bool exit_flag = false;
+
+    WorkerPool (const WorkerPool&) = delete;
+    WorkerPool& operator= (const WorkerPool&) = delete;
+
+    void submit (uint32_t index, Task&& task) {
+        auto& q = *queues[index % queues.size()];
+        {
+            std::lock_guard<std::mutex> ql (q.lock);
+            q.tasks.push_back (std::move (task));
+            ++pending;
+        }
+        // sync with threads between checking pending and going to sleep
+        {
+            std::lock_guard<std::mutex> sl (lock);
+        }
+        wake.notify_one();
+    }
+
+    /** Pop from the front of our own queue, or steal from the back of another.
+        Counts down under the queue's lock, so while pending is above zero
+        there is always a task to take.
+     */
+    bool take (uint32_t self, Task& task) {
+        const auto n = (uint32_t) queues.size();
+        for (uint32_t i = 0; i < n; ++i) {
+            auto& q = *queues[(self + i) % n];
+            std::lock_guard<std::mutex> ql (q.lock);
+            if (q.tasks.empty())
+                continue;
+            if (i == 0) {
+                task = std::move (q.tasks.front());
+                q.tasks.pop_front();
+            } else {
+                task = std::move (q.tasks.back());
+                q.tasks.pop_back();
+            }
+            --pending;
+            return true;
+        }
+        return false;
+    }
+
+    bool run_one (uint32_t self) {
+        Task task;
+        if (! take (self, task))
+            return false;
+        task();
+        return true;
+    }
+
+    void process (uint32_t self) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> sl (lock);
+                wake.wait (sl, [this] { return exit_flag || pending > 0; });
+                if (exit_flag)
+                    break;
+            }
+            run_one (self);
+        }
+    }
+};
+
+} // namespace lvtk
@@ -0,0 +1,261 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace lvtk {
+
+/** A small LZ4 block codec.
+
+    Output is a plain LZ4 block, readable by any LZ4 implementation.  The
+    compressor is a single-pass greedy matcher with no allocation; the
+    decompressor checks every bound so corrupt input fails instead of
+    overrunning.
+
+    @headerfile lvtk/lz4.hpp
+    @ingroup lvtk
+ */
+namespace lz4 {
+
+/** @returns the largest size `compress` can produce for `size` bytes */
+constexpr size_t compress_bound (size_t size) noexcept {
+    return size + size / 255 + 16;
+}
+
+namespace detail {
+static constexpr uint32_t hash_bits = 12;
+static constexpr size_t min_match = 4;
+static constexpr size_t last_literals = 5;
+static constexpr size_t match_start_limit = 12;
+static constexpr size_t max_offset = 65535;
+
+inline bool is_little_endian() noexcept {
+    const uint16_t one = 1;
+    uint8_t first;
+    std::memcpy (&first, &one, 1);
+    return first == 1;
+}
+
+inline uint32_t read32 (const uint8_t* p) noexcept {
+    uint32_t v;
+    std::memcpy (&v, p, sizeof (v));
+    return v;
+}
+
+inline uint64_t read64 (const uint8_t* p) noexcept {
+    uint64_t v;
+    std::memcpy (&v, p, sizeof (v));
+    return v;
+}
+
+/** Number of equal leading bytes given the XOR of two words */
+inline size_t count_equal (uint64_t diff) noexcept {
+    size_t n = 0;
+    if (is_little_endian()) {
+        while ((diff & 0xff) == 0) {
+            diff >>= 8;
+            ++n;
+        }
+    } else {
+        while ((diff >> 56) == 0) {
+            diff <<= 8;
+            ++n;
+        }
+    }
+    return n;
+}
+
+inline uint32_t hash (uint32_t v) noexcept {
+    return (v * 2654435761u) >> (32 - hash_bits);
+}
+
+inline uint8_t* write_length (uint8_t* op, size_t length) noexcept {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t) length;
+    return op;
+}
+
+inline uint8_t* write_literals (uint8_t* op, uint8_t*& token,
+                                const uint8_t* anchor, size_t length) noexcept {
+    token = op++;
+    *token = (uint8_t) ((length >= 15 ? 15 : length) << 4);
+    if (length >= 15)
+        op = write_length (op, length - 15);
+    if (length > 0)
+        std::memcpy (op, anchor, length);
+    return op + length;
+}
+} // namespace detail
+
+/** Compress a block.
+
+    @param src      Bytes to compress
+    @param size     Number of bytes
+    @param dst      Output buffer
+    @param capacity Size of the output. Must be at least compress_bound (size)
+    @returns the compressed size, or zero if dst is too small
+ */
+inline size_t compress (const void* src, size_t size, void* dst, size_t capacity) noexcept {
+    using namespace detail;
+    if (capacity < compress_bound (size))
+        return 0;
+
+    const auto* const in = static_cast<const uint8_t*> (src);
+    const uint8_t* const end = in + size;
+    const uint8_t* ip = in;
+    const uint8_t* anchor = in;
+    auto* const out = static_cast<uint8_t*> (dst);
+    uint8_t* op = out;
+    uint8_t* token = nullptr;
+
+    if (size > match_start_limit) {
+        const uint8_t* const start_limit = end - match_start_limit;
+        const uint8_t* const match_limit = end - last_literals;
+        uint32_t table[1u << hash_bits] = {};
+
+        while (ip < start_limit) {
+            const uint32_t seq = read32 (ip);
+            const uint32_t h = hash (seq);
+            const uint8_t* ref = in + table[h];
+            table[h] = (uint32_t) (ip - in);
+
+            if (ref >= ip || (size_t) (ip - ref) > max_offset || read32 (ref) != seq) {
+                ++ip;
+                continue;
+            }
+
+            // extend backwards into pending literals, then forwards
+            while (ip > anchor && ref > in && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+
+            const uint8_t* mp = ip + min_match;
+            const uint8_t* rp = ref + min_match;
+            for (;;) {
+                if (mp + sizeof (uint64_t) > match_limit) {
+                    while (mp < match_limit && *mp == *rp) {
+                        ++mp;
+                        ++rp;
+                    }
+                    break;
+                }
+                const uint64_t diff = read64 (mp) ^ read64 (rp);
+                if (diff != 0) {
+                    mp += count_equal (diff);
+                    break;
+                }
+                mp += sizeof (uint64_t);
+                rp += sizeof (uint64_t);
+            }
+
+            op = write_literals (op, token, anchor, (size_t) (ip - anchor));
+            const auto offset = (uint16_t) (ip - ref);
+            *op++ = (uint8_t) (offset & 0xff);
+            *op++ = (uint8_t) (offset >> 8);
+
+            const size_t length = (size_t) (mp - ip) - min_match;
+            *token |= (uint8_t) (length >= 15 ? 15 : length);
+            if (length >= 15)
+                op = write_length (op, length - 15);
+
+            ip = anchor = mp;
+        }
+    }
+
+    op = write_literals (op, token, anchor, (size_t) (end - anchor));
+    return (size_t) (op - out);
+}
+
+/** Decompress a block.
+
+    @param src      Compressed bytes
+    @param size     Number of compressed bytes
+    @param dst      Output buffer
+    @param capacity Size of the output buffer
+    @returns the decompressed size, or zero if the input is corrupt or
+             doesn't fit
+ */
+inline size_t decompress (const void* src, size_t size, void* dst, size_t capacity) noexcept {
+    using namespace detail;
+    const auto* ip = static_cast<const uint8_t*> (src);
+    const uint8_t* const iend = ip + size;
+    auto* const out = static_cast<uint8_t*> (dst);
+    uint8_t* op = out;
+    uint8_t* const oend = out + capacity;
+
+    auto read_length = [&] (size_t& length) {
+        uint8_t b;
+        do {
+            if (ip >= iend)
+                return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        size_t length = token >> 4;
+        if (length < 15 && iend - ip >= 16 && oend - op >= 16) {
+            // short literals: copy a fixed 16 bytes, the excess is overwritten
+            std::memcpy (op, ip, 16);
+        } else {
+            if (length == 15 && ! read_length (length))
+                return 0;
+            if (length > (size_t) (iend - ip) || length > (size_t) (oend - op))
+                return 0;
+            if (length > 0)
+                std::memcpy (op, ip, length);
+        }
+        ip += length;
+        op += length;
+
+        if (ip == iend)
+            break;
+        if (iend - ip < 2)
+            return 0;
+
+        const size_t offset = (size_t) ip[0] | ((size_t) ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t) (op - out))
+            return 0;
+
+        length = token & 15;
+        if (length == 15 && ! read_length (length))
+            return 0;
+        length += min_match;
+        if (length > (size_t) (oend - op))
+            return 0;
+
+        const uint8_t* const match = op - offset;
+        if (length <= 16 && offset >= 16 && oend - op >= 16) {
+            std::memcpy (op, match, 16);
+            op += length;
+            continue;
+        }
+
+        // overlapping matches repeat the pattern, which doubles each pass
+        while (length > 0) {
+            const size_t chunk = std::min ((size_t) (op - match), length);
+            std::memcpy (op, match, chunk);
+            op += chunk;
+            length -= chunk;
+        }
+    }
+
+    return (size_t) (op - out);
+}
+
+} // namespace lz4
+} // namespace lvtk
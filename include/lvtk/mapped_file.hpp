@@ -0,0 +1,152 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace lvtk {
+
+/** A read-only, memory mapped file.
+
+    Pages are loaded by the OS as they are touched, so opening a large file
+    is cheap and nothing is copied onto the heap.  Movable, not copyable.
+
+    @headerfile lvtk/mapped_file.hpp
+    @ingroup lvtk
+ */
+class MappedFile final {
+public:
+    MappedFile() = default;
+
+    /** Map a file.
+        @param path Absolute path of the file
+     */
+    explicit MappedFile (const char* path) { open (path); }
+
+    MappedFile (MappedFile&& o) noexcept { swap (o); }
+    MappedFile& operator= (MappedFile&& o) noexcept {
+        close();
+        swap (o);
+        return *this;
+    }
+
+    ~MappedFile() { close(); }
+
+    /** Map a file, closing any file previously mapped.
+        @returns true if the file was mapped
+     */
+    bool open (const char* path) {
+        close();
+        if (path == nullptr)
+            return false;
+#if defined(_WIN32)
+        file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER li;
+        if (! GetFileSizeEx (file, &li)) {
+            close();
+            return false;
+        }
+        length = (size_t) li.QuadPart;
+        opened = true;
+        if (length == 0)
+            return true;
+        mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+            address = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+        fd = ::open (path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat (fd, &st) != 0) {
+            close();
+            return false;
+        }
+        length = (size_t) st.st_size;
+        opened = true;
+        if (length == 0)
+            return true;
+        address = mmap (nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+            address = nullptr;
+#endif
+        if (address == nullptr)
+            close();
+        return opened;
+    }
+
+    /** Unmap the file */
+    void close() noexcept {
+#if defined(_WIN32)
+        if (address != nullptr)
+            UnmapViewOfFile (address);
+        if (mapping != nullptr)
+            CloseHandle (mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle (file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (address != nullptr)
+            munmap (address, length);
+        if (fd >= 0)
+            ::close (fd);
+        fd = -1;
+#endif
+        address = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+    /** @returns the mapped bytes, or nullptr if not open or empty */
+    const void* data() const noexcept { return address; }
+
+    /** @returns the size of the file in bytes */
+    size_t size() const noexcept { return length; }
+
+    /** @returns true if a file is mapped */
+    bool is_open() const noexcept { return opened; }
+    operator bool() const noexcept { return opened; }
+
+private:
+    void* address = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    void swap (MappedFile& o) noexcept {
+        std::swap (address, o.address);
+        std::swap (length, o.length);
+        std::swap (opened, o.opened);
+#if defined(_WIN32)
+        std::swap (file, o.file);
+        std::swap (mapping, o.mapping);
+#else
+        std::swap (fd, o.fd);
+#endif
+    }
+
+    MappedFile (const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+};
+
+} // namespace lvtk
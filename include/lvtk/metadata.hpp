@@ -0,0 +1,512 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+/** @defgroup metadata Metadata
+    Plugin descriptions declared in C++
+
+    Ports and properties are declared once as constexpr data.  The same
+    declarations produce the plugin's Turtle, either at build time or from
+    a @ref DynManifest, and the port table the plugin uses in run().
+
+    <h3>Example</h3>
+    @code
+    static constexpr lvtk::PortInfo gain_ports[] = {
+        lvtk::audio_input ("in", "In"),
+        lvtk::audio_output ("out", "Out"),
+        lvtk::control_input ("gain", "Gain", 0.f, 2.f, 1.f)
+    };
+
+    static constexpr auto gain_info = lvtk::PluginInfo ("http://myplugin.org", "Gain", gain_ports)
+                                          .with_class (LV2_CORE__AmplifierPlugin);
+
+    class Gain : public lvtk::Plugin<Gain> {
+    public:
+        void connect_port (uint32_t port, void* data) { ports.connect (port, data); }
+        void run (uint32_t nframes) {
+            const float gain = ports.control<2>(); // clamped to 0..2
+            ...
+        }
+
+    private:
+        lvtk::PortTable<gain_ports> ports;
+    };
+    @endcode
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace lvtk {
+
+/** Kind of data a port carries
+    @ingroup metadata
+ */
+enum class PortType : uint8_t {
+    Audio,   /**< lv2:AudioPort */
+    Control, /**< lv2:ControlPort */
+    CV,      /**< lv2:CVPort */
+    Atom     /**< atom:AtomPort holding an atom:Sequence */
+};
+
+namespace detail {
+/** True unless value is infinite or NaN, usable in constant expressions */
+constexpr bool is_finite (float value) noexcept {
+    return value >= -std::numeric_limits<float>::max()
+           && value <= std::numeric_limits<float>::max();
+}
+
+/** Turtle has no decimal form of inf or nan, so ranges must be finite.
+    Fails to compile when the port is constexpr. */
+constexpr void check_port_range (float min, float max, float def) {
+    if (! is_finite (min) || ! is_finite (max) || ! is_finite (def))
+        throw std::invalid_argument ("lvtk: port ranges must be finite");
+}
+} // namespace detail
+
+/** A labelled control value
+    @ingroup metadata
+ */
+struct ScalePoint {
+    const char* label;
+    float value;
+};
+
+/** Description of a single port.
+
+    Ports get their index from their position in the plugin's port array.
+    Use the constexpr helpers like @ref control_input to declare them.
+
+    @ingroup metadata
+    @headerfile lvtk/metadata.hpp
+ */
+struct PortInfo {
+    PortType type;
+    bool input;
+    const char* symbol;
+    const char* name;
+    bool ranged = false; /**< True if min, max and def are set */
+    float min = 0.f;
+    float max = 1.f;
+    float def = 0.f;
+    const char* unit = nullptr;        /**< Unit URI, e.g. LV2_UNITS__db */
+    const ScalePoint* points = nullptr;
+    uint32_t num_points = 0;
+
+    /** @returns a copy with a unit */
+    constexpr PortInfo with_unit (const char* uri) const {
+        auto p = *this;
+        p.unit = uri;
+        return p;
+    }
+
+    /** @returns a copy with scale points
+        @throws std::invalid_argument if a value isn't finite
+     */
+    template <size_t N>
+    constexpr PortInfo with_scale_points (const ScalePoint (&sp)[N]) const {
+        for (const auto& point : sp)
+            detail::check_port_range (point.value, point.value, point.value);
+        auto p = *this;
+        p.points = sp;
+        p.num_points = (uint32_t) N;
+        return p;
+    }
+
+    /** @returns value clamped to the port's range, or the default if NaN */
+    constexpr float clamp (float value) const noexcept {
+        if (! ranged)
+            return value;
+        if (value != value)
+            return def;
+        return value < min ? min : (value > max ? max : value);
+    }
+};
+
+/** @ingroup metadata */
+constexpr PortInfo audio_input (const char* symbol, const char* name) {
+    return { PortType::Audio, true, symbol, name };
+}
+
+/** @ingroup metadata */
+constexpr PortInfo audio_output (const char* symbol, const char* name) {
+    return { PortType::Audio, false, symbol, name };
+}
+
+/** @ingroup metadata */
+constexpr PortInfo cv_input (const char* symbol, const char* name) {
+    return { PortType::CV, true, symbol, name };
+}
+
+/** @ingroup metadata */
+constexpr PortInfo cv_output (const char* symbol, const char* name) {
+    return { PortType::CV, false, symbol, name };
+}
+
+/** @ingroup metadata */
+constexpr PortInfo atom_input (const char* symbol, const char* name) {
+    return { PortType::Atom, true, symbol, name };
+}
+
+/** @ingroup metadata */
+constexpr PortInfo atom_output (const char* symbol, const char* name) {
+    return { PortType::Atom, false, symbol, name };
+}
+
+/** A control input. Values read through a @ref PortTable are clamped
+    to min and max.
+    @throws std::invalid_argument if the range isn't finite
+    @ingroup metadata
+ */
+constexpr PortInfo control_input (const char* symbol, const char* name,
+                                  float min, float max, float def) {
+    detail::check_port_range (min, max, def);
+    return { PortType::Control, true, symbol, name, true, min, max, def };
+}
+
+/** @ingroup metadata */
+constexpr PortInfo control_output (const char* symbol, const char* name) {
+    return { PortType::Control, false, symbol, name };
+}
+
+/** @throws std::invalid_argument if the range isn't finite
+    @ingroup metadata
+ */
+constexpr PortInfo control_output (const char* symbol, const char* name,
+                                   float min, float max) {
+    detail::check_port_range (min, max, min);
+    return { PortType::Control, false, symbol, name, true, min, max, min };
+}
+
+/** Description of a plugin.
+
+    @code
+    static constexpr auto info = lvtk::PluginInfo (URI, "Name", ports)
+                                     .with_license ("https://opensource.org/licenses/ISC")
+                                     .with_ui (URI "/ui");
+    @endcode
+
+    @ingroup metadata
+    @headerfile lvtk/metadata.hpp
+ */
+struct PluginInfo {
+    const char* uri;
+    const char* name;
+    const PortInfo* ports;
+    uint32_t num_ports;
+    const char* type = nullptr;    /**< Plugin class URI besides lv2:Plugin */
+    const char* license = nullptr;
+    const char* project = nullptr;
+    const char* ui = nullptr;
+    const char* const* features = nullptr; /**< Optional features */
+    uint32_t num_features = 0;
+    uint32_t minor_version = 0;
+    uint32_t micro_version = 0;
+
+    template <size_t N>
+    constexpr PluginInfo (const char* uri, const char* name, const PortInfo (&p)[N])
+        : uri (uri), name (name), ports (p), num_ports ((uint32_t) N) {}
+
+    constexpr PluginInfo with_class (const char* class_uri) const {
+        auto i = *this;
+        i.type = class_uri;
+        return i;
+    }
+
+    constexpr PluginInfo with_license (const char* license_uri) const {
+        auto i = *this;
+        i.license = license_uri;
+        return i;
+    }
+
+    constexpr PluginInfo with_project (const char* project_uri) const {
+        auto i = *this;
+        i.project = project_uri;
+        return i;
+    }
+
+    constexpr PluginInfo with_ui (const char* ui_uri) const {
+        auto i = *this;
+        i.ui = ui_uri;
+        return i;
+    }
+
+    template <size_t N>
+    constexpr PluginInfo with_optional_features (const char* const (&f)[N]) const {
+        auto i = *this;
+        i.features = f;
+        i.num_features = (uint32_t) N;
+        return i;
+    }
+
+    constexpr PluginInfo with_version (uint32_t minor, uint32_t micro) const {
+        auto i = *this;
+        i.minor_version = minor;
+        i.micro_version = micro;
+        return i;
+    }
+
+    /** @returns the index of a port, or num_ports if not found */
+    constexpr uint32_t port_index (const char* symbol) const noexcept {
+        for (uint32_t i = 0; i < num_ports; ++i) {
+            const char* a = ports[i].symbol;
+            const char* b = symbol;
+            while (*a != 0 && *a == *b)
+                ++a, ++b;
+            if (*a == *b)
+                return i;
+        }
+        return num_ports;
+    }
+};
+
+/** Port buffers for a constexpr port array.
+
+    Replaces a hand written connect_port.  Accessors take the port index
+    as a template argument, so types and ranges are checked and applied
+    at compile time.
+
+    @tparam Ports   A static constexpr PortInfo array
+    @ingroup metadata
+    @headerfile lvtk/metadata.hpp
+ */
+template <const auto& Ports>
+class PortTable final {
+public:
+    /** Number of ports */
+    static constexpr uint32_t size = (uint32_t) std::size (Ports);
+
+    /** Call from the plugin's connect_port */
+    void connect (uint32_t port, void* data) noexcept {
+        if (port < size)
+            buffers[port] = data;
+    }
+
+    /** @returns the buffer of an audio or CV port */
+    template <uint32_t I>
+    float* audio() const noexcept {
+        static_assert (I < size, "Port index out of range");
+        static_assert (Ports[I].type == PortType::Audio || Ports[I].type == PortType::CV,
+                       "Not an audio or CV port");
+        return static_cast<float*> (buffers[I]);
+    }
+
+    /** @returns the value of a control input clamped to its range */
+    template <uint32_t I>
+    float control() const noexcept {
+        static_assert (I < size, "Port index out of range");
+        static_assert (Ports[I].type == PortType::Control && Ports[I].input,
+                       "Not a control input");
+        constexpr PortInfo port = Ports[I];
+        return port.clamp (*static_cast<const float*> (buffers[I]));
+    }
+
+    /** Write a control output, clamped to its range */
+    template <uint32_t I>
+    void set_control (float value) noexcept {
+        static_assert (I < size, "Port index out of range");
+        static_assert (Ports[I].type == PortType::Control && ! Ports[I].input,
+                       "Not a control output");
+        constexpr PortInfo port = Ports[I];
+        *static_cast<float*> (buffers[I]) = port.clamp (value);
+    }
+
+    /** @returns the raw buffer of any port */
+    template <uint32_t I>
+    void* data() const noexcept {
+        static_assert (I < size, "Port index out of range");
+        return buffers[I];
+    }
+
+    /** @returns true if every port has been connected */
+    bool connected() const noexcept {
+        for (auto b : buffers)
+            if (b == nullptr)
+                return false;
+        return true;
+    }
+
+private:
+    void* buffers[size] {};
+};
+
+namespace detail {
+struct TurtlePrefix {
+    const char* name;
+    const char* uri;
+};
+
+static constexpr TurtlePrefix turtle_prefixes[] = {
+    { "atom", "http://lv2plug.in/ns/ext/atom#" },
+    { "doap", "http://usefulinc.com/ns/doap#" },
+    { "lv2", "http://lv2plug.in/ns/lv2core#" },
+    { "rdf", "http://www.w3.org/1999/02/22-rdf-syntax-ns#" },
+    { "rdfs", "http://www.w3.org/2000/01/rdf-schema#" },
+    { "ui", "http://lv2plug.in/ns/extensions/ui#" },
+    { "units", "http://lv2plug.in/ns/extensions/units#" }
+};
+
+/** Writes a URI, shortened with a known prefix if possible */
+template <typename Out>
+inline void write_turtle_uri (Out& out, const char* uri) {
+    for (const auto& prefix : turtle_prefixes) {
+        const auto length = std::strlen (prefix.uri);
+        if (std::strncmp (uri, prefix.uri, length) != 0 || uri[length] == 0)
+            continue;
+        const char* local = uri + length;
+        bool simple = true;
+        for (const char* c = local; *c != 0 && simple; ++c)
+            simple = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')
+                     || (*c >= '0' && *c <= '9') || *c == '_';
+        if (simple) {
+            out << prefix.name << ":" << local;
+            return;
+        }
+    }
+    out << "<" << uri << ">";
+}
+
+template <typename Out>
+inline void write_turtle_string (Out& out, const char* str) {
+    out << "\"";
+    for (const char* c = str; *c != 0; ++c) {
+        const char s[2] = { *c, 0 };
+        if (*c == '"' || *c == '\\')
+            out << "\\" << s;
+        else if (*c == '\n')
+            out << "\\n";
+        else
+            out << s;
+    }
+    out << "\"";
+}
+
+/** Writes a float as a Turtle decimal, e.g. -90.0 rather than -90 */
+template <typename Out>
+inline void write_turtle_number (Out& out, float value) {
+    char str[32];
+    std::snprintf (str, sizeof (str), "%.9g", (double) value);
+    out << str;
+    if (std::strpbrk (str, ".en") == nullptr)
+        out << ".0";
+}
+} // namespace detail
+
+/** Write the @prefix lines used by write_turtle
+    @ingroup metadata
+ */
+template <typename Out>
+inline void write_turtle_prefixes (Out& out) {
+    for (const auto& prefix : detail::turtle_prefixes)
+        out << "@prefix " << prefix.name << ": <" << prefix.uri << "> .\n";
+    out << "\n";
+}
+
+/** Write a plugin description as Turtle.
+
+    Writes the prefixes followed by the plugin's triples. `Out` can be a
+    std::ostream or a @ref ManifestWriter.
+
+    @ingroup metadata
+ */
+template <typename Out>
+inline void write_turtle (Out& out, const PluginInfo& info) {
+    write_turtle_prefixes (out);
+    out << "<" << info.uri << ">\n\ta lv2:Plugin";
+    if (info.type != nullptr) {
+        out << " , ";
+        detail::write_turtle_uri (out, info.type);
+    }
+    out << " ;\n\tdoap:name ";
+    detail::write_turtle_string (out, info.name);
+    if (info.license != nullptr)
+        out << " ;\n\tdoap:license <" << info.license << ">";
+    if (info.project != nullptr)
+        out << " ;\n\tlv2:project <" << info.project << ">";
+    out << " ;\n\tlv2:minorVersion " << info.minor_version
+        << " ;\n\tlv2:microVersion " << info.micro_version;
+    if (info.ui != nullptr)
+        out << " ;\n\tui:ui <" << info.ui << ">";
+    for (uint32_t i = 0; i < info.num_features; ++i) {
+        out << " ;\n\tlv2:optionalFeature ";
+        detail::write_turtle_uri (out, info.features[i]);
+    }
+
+    for (uint32_t i = 0; i < info.num_ports; ++i) {
+        const auto& port = info.ports[i];
+        out << (i == 0 ? " ;\n\tlv2:port [\n" : " , [\n");
+
+        static const char* const types[] = { "lv2:AudioPort", "lv2:ControlPort",
+                                             "lv2:CVPort", "atom:AtomPort" };
+        out << "\t\ta " << types[(int) port.type] << " , "
+            << (port.input ? "lv2:InputPort" : "lv2:OutputPort") << " ;\n";
+        if (port.type == PortType::Atom)
+            out << "\t\tatom:bufferType atom:Sequence ;\n";
+        out << "\t\tlv2:index " << i << " ;\n\t\tlv2:symbol ";
+        detail::write_turtle_string (out, port.symbol);
+        out << " ;\n\t\tlv2:name ";
+        detail::write_turtle_string (out, port.name);
+
+        if (port.ranged) {
+            out << " ;\n\t\tlv2:minimum ";
+            detail::write_turtle_number (out, port.min);
+            out << " ;\n\t\tlv2:maximum ";
+            detail::write_turtle_number (out, port.max);
+            if (port.input) {
+                out << " ;\n\t\tlv2:default ";
+                detail::write_turtle_number (out, port.def);
+            }
+        }
+
+        if (port.unit != nullptr) {
+            out << " ;\n\t\tunits:unit ";
+            detail::write_turtle_uri (out, port.unit);
+        }
+
+        for (uint32_t p = 0; p < port.num_points; ++p) {
+            out << (p == 0 ? " ;\n\t\tlv2:scalePoint [\n" : " , [\n");
+            out << "\t\t\trdfs:label ";
+            detail::write_turtle_string (out, port.points[p].label);
+            out << " ;\n\t\t\trdf:value ";
+            detail::write_turtle_number (out, port.points[p].value);
+            out << "\n\t\t]";
+        }
+
+        out << "\n\t]";
+    }
+
+    out << " .\n";
+}
+
+/** Write a plugin description to a Turtle file.
+    @returns true on success
+    @ingroup metadata
+ */
+inline bool write_turtle_file (const char* path, const PluginInfo& info) {
+    struct FileOut {
+        FILE* file;
+        FileOut& operator<< (const char* str) {
+            std::fputs (str, file);
+            return *this;
+        }
+        FileOut& operator<< (uint32_t value) {
+            std::fprintf (file, "%u", value);
+            return *this;
+        }
+    };
+
+    FileOut out { std::fopen (path, "w") };
+    if (out.file == nullptr)
+        return false;
+    write_turtle (out, info);
+    const bool ok = ! std::ferror (out.file);
+    return std::fclose (out.file) == 0 && ok;
+}
+
+} // namespace lvtk
@@ -3,15 +3,38 @@
 
 #pragma once
 
-#include <cassert>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
 #include <lvtk/ext/options.hpp>
 
+/** Number of options an OptionArray holds before allocating */
+#ifndef LVTK_OPTION_ARRAY_INLINE_SIZE
+    #define LVTK_OPTION_ARRAY_INLINE_SIZE 16
+#endif
+
 namespace lvtk {
 
 /** An array of Options
 
     Plugin implementations don't need to use this.  You can, however, use this 
-    in an LV2 host to easily provide URID map/unmaping features to plugins.
+    in an LV2 host to easily provide options to plugins.
+
+    Up to LVTK_OPTION_ARRAY_INLINE_SIZE options are stored inside the array
+    itself, beyond that storage grows geometrically.  Values added with the
+    typed `add` are copied into the array, so it doesn't depend on outside
+    storage.  `clear` keeps the storage, so one array can be refilled for
+    each instantiation without allocating.
+
+    @code
+        lvtk::OptionArray options;
+        options.add (map (LV2_BUF_SIZE__maxBlockLength), map (LV2_ATOM__Int), (int32_t) 4096)
+               .add (map (LV2_PARAMETERS__sampleRate), map (LV2_ATOM__Float), 48000.f);
+        const LV2_Feature feature = { LV2_OPTIONS__options, (void*) options.get() };
+    @endcode
 
     @headerfile lvtk/options.hpp
     @ingroup options
@@ -35,35 +58,101 @@ public:
         @param ref  Naked Option array to reference
      */
     OptionArray (const Option* ref)
-        : allocated (false), count (0), opts (const_cast<Option*> (ref)) {
-        for (;;) {
-            auto& opt = ref[count++];
-            if (opt.key == 0 || opt.value == nullptr) {
-                break;
-            }
-        }
-        assert (count >= 1);
+        : allocated (false), opts (const_cast<Option*> (ref)) {
+        while (ref[count].key != 0 && ref[count].value != nullptr)
+            ++count;
     }
 
     /** A new Option array.
         
-        Using this ctor will allocate memory and allow `add` to function. It
-        will maintain a zeroed end Option so client code doesn't have to
-        worry about it.
+        Using this ctor allows `add` to function. It will maintain a zeroed
+        end Option so client code doesn't have to worry about it.
         
         This version is intended to be used by an LV2 host.
      */
-    OptionArray() {
-        opts = (Option*) malloc (sizeof (Option));
-        memset (&opts[0], 0, sizeof (Option));
-        allocated = true;
-        count = 1;
+    OptionArray() noexcept {
+        std::memset (&opts[0], 0, sizeof (Option));
+    }
+
+    /** Copy options. Values owned by @p other are copied too, a
+        referenced array stays referenced. */
+    OptionArray (const OptionArray& other) { *this = other; }
+
+    /** Take the storage of @p other, which is left empty */
+    OptionArray (OptionArray&& other) noexcept { *this = std::move (other); }
+
+    ~OptionArray() = default;
+
+    OptionArray& operator= (const OptionArray& other) {
+        if (this == &other)
+            return *this;
+        if (! other.allocated) {
+            refer_to (other.opts, other.count);
+            return *this;
+        }
+
+        clear();
+        reserve (other.count);
+        reserve_values (other.value_count);
+        copy_from (other);
+        return *this;
+    }
+
+    OptionArray& operator= (OptionArray&& other) noexcept {
+        if (this == &other)
+            return *this;
+        if (! other.allocated) {
+            refer_to (other.opts, other.count);
+            return *this;
+        }
+
+        clear();
+        const auto old_values = reinterpret_cast<const uint8_t*> (other.values);
+        const size_t old_bytes = other.value_count * sizeof (uint64_t);
+
+        if (other.heap_values != nullptr) {
+            heap_values = std::move (other.heap_values);
+            values = heap_values.get();
+            value_capacity = other.value_capacity;
+        } else {
+            std::memcpy (values, other.values, old_bytes);
+        }
+        value_count = other.value_count;
+
+        if (other.heap_options != nullptr) {
+            heap_options = std::move (other.heap_options);
+            opts = heap_options.get();
+            capacity = other.capacity;
+        } else {
+            std::memcpy (opts, other.opts, (other.count + 1) * sizeof (Option));
+        }
+        count = other.count;
+        rebase (old_values, old_bytes);
+
+        other.reset_storage();
+        return *this;
+    }
+
+    /** Make room for @p num_options without allocating again.
+        Does nothing if data is referenced */
+    void reserve (size_type num_options) {
+        if (! allocated || num_options <= capacity)
+            return;
+        std::unique_ptr<Option[]> storage (new Option[num_options + 1]);
+        std::memcpy (storage.get(), opts, (count + 1) * sizeof (Option));
+        heap_options = std::move (storage);
+        opts = heap_options.get();
+        capacity = num_options;
     }
 
-    ~OptionArray() {
-        if (allocated && opts != nullptr)
-            std::free (opts);
-        opts = nullptr;
+    /** Remove all options, keeping storage for reuse.  A referenced
+        array becomes a new empty one. */
+    void clear() noexcept {
+        if (! allocated)
+            reset_storage();
+        count = 0;
+        value_count = 0;
+        std::memset (&opts[0], 0, sizeof (Option));
     }
 
     /** Add an option. Does nothing if data is referenced */
@@ -71,7 +160,10 @@ public:
         return add (option.context, option.subject, option.key, option.size, option.type, option.value);
     }
 
-    /** Add an option. Does nothing if data is referenced */
+    /** Add an option. Does nothing if data is referenced
+
+        The value is not copied and must outlive the array.
+     */
     OptionArray& add (OptionsContext context,
                       uint32_t subject,
                       LV2_URID key,
@@ -80,22 +172,57 @@ public:
                       const void* value) {
         if (! allocated)
             return *this;
-        opts = (Option*) realloc (opts, ++count * sizeof (Option));
-        memset (&opts[count - 1], 0, sizeof (Option));
-        auto& opt = opts[count - 2];
+        if (count == capacity)
+            reserve (std::max<size_type> (count * 2, LVTK_OPTION_ARRAY_INLINE_SIZE));
+
+        auto& opt = opts[count];
         opt.context = context;
         opt.subject = subject;
         opt.key = key;
         opt.size = size;
         opt.type = type;
         opt.value = value;
+        std::memset (&opts[++count], 0, sizeof (Option));
         return *this;
     }
 
+    /** Add an option with a copy of its value. Does nothing if data is
+        referenced
+
+        @param context  Option context
+        @param subject  Option subject
+        @param key      Option key
+        @param type     Value type
+        @param value    The value, copied into the array
+     */
+    template <typename T>
+    OptionArray& add (OptionsContext context, uint32_t subject, LV2_URID key,
+                      LV2_URID type, const T& value) {
+        static_assert (std::is_trivially_copyable<T>::value, "Option values must be trivially copyable");
+        static_assert (alignof (T) <= alignof (uint64_t), "Option value alignment not supported");
+        if (! allocated)
+            return *this;
+
+        const size_t words = (sizeof (T) + sizeof (uint64_t) - 1) / sizeof (uint64_t);
+        if (value_count + words > value_capacity)
+            reserve_values (std::max (value_count + words, value_capacity * 2));
+        auto data = values + value_count;
+        std::memcpy (data, &value, sizeof (T));
+        value_count += words;
+        return add (context, subject, key, sizeof (T), type, data);
+    }
+
+    /** Add an instance option with a copy of its value. Does nothing if
+        data is referenced */
+    template <typename T>
+    OptionArray& add (LV2_URID key, LV2_URID type, const T& value) {
+        return add (LV2_OPTIONS_INSTANCE, 0, key, type, value);
+    }
+
     /** Returns the number of options stored excluding the zeroed end
         option as per LV2 specifications
      */
-    size_type size() const { return count - 1; }
+    size_type size() const { return count; }
 
     /** Returns true if empty */
     bool empty() const { return size() == 0; }
@@ -137,9 +264,73 @@ public:
     iterator end() const { return iterator (opts, size()); }
 
 private:
-    bool allocated = false;
-    uint32_t count = 0;
-    Option* opts = nullptr;
+    bool allocated = true;
+    size_type count = 0;
+    size_type capacity = LVTK_OPTION_ARRAY_INLINE_SIZE;
+    Option* opts = inline_options;
+    std::unique_ptr<Option[]> heap_options;
+
+    size_t value_count = 0;
+    size_t value_capacity = LVTK_OPTION_ARRAY_INLINE_SIZE;
+    uint64_t* values = inline_values;
+    std::unique_ptr<uint64_t[]> heap_values;
+
+    Option inline_options[LVTK_OPTION_ARRAY_INLINE_SIZE + 1];
+    uint64_t inline_values[LVTK_OPTION_ARRAY_INLINE_SIZE];
+
+    void refer_to (Option* ref, size_type size) noexcept {
+        reset_storage();
+        allocated = false;
+        opts = ref;
+        count = size;
+    }
+
+    void reset_storage() noexcept {
+        allocated = true;
+        heap_options.reset();
+        heap_values.reset();
+        opts = inline_options;
+        values = inline_values;
+        capacity = LVTK_OPTION_ARRAY_INLINE_SIZE;
+        value_capacity = LVTK_OPTION_ARRAY_INLINE_SIZE;
+        count = 0;
+        value_count = 0;
+        std::memset (&opts[0], 0, sizeof (Option));
+    }
+
+    void reserve_values (size_t words) {
+        if (words <= value_capacity)
+            return;
+        const auto old_values = reinterpret_cast<const uint8_t*> (values);
+        std::unique_ptr<uint64_t[]> storage (new uint64_t[words]);
+        if (value_count > 0)
+            std::memcpy (storage.get(), values, value_count * sizeof (uint64_t));
+        heap_values = std::move (storage);
+        values = heap_values.get();
+        value_capacity = words;
+        rebase (old_values, value_count * sizeof (uint64_t));
+    }
+
+    void copy_from (const OptionArray& other) {
+        if (other.value_count > 0)
+            std::memcpy (values, other.values, other.value_count * sizeof (uint64_t));
+        value_count = other.value_count;
+        std::memcpy (opts, other.opts, (other.count + 1) * sizeof (Option));
+        count = other.count;
+        rebase (reinterpret_cast<const uint8_t*> (other.values),
+                other.value_count * sizeof (uint64_t));
+    }
+
+    /** Point values which were copied from old storage at the new one */
+    void rebase (const uint8_t* old_values, size_t bytes) noexcept {
+        const auto begin = reinterpret_cast<uintptr_t> (old_values);
+        const auto end = begin + bytes;
+        for (size_type i = 0; i < count; ++i) {
+            const auto addr = reinterpret_cast<uintptr_t> (opts[i].value);
+            if (addr >= begin && addr < end)
+                opts[i].value = reinterpret_cast<const uint8_t*> (values) + (addr - begin);
+        }
+    }
 };
 
 }
@@ -0,0 +1,298 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <lv2/atom/atom.h>
+#include <lv2/ui/ui.h>
+#include <lvtk/ext/ui/port_map.hpp>
+#include <lvtk/ext/urid.hpp>
+
+namespace lvtk {
+
+/** A queue of port values and events.
+
+    Keeps only the latest float value of each port until `flush`, and
+    copies anything else to be passed on in order.  A value pushed before
+    an event is flushed before that event, so the receiver sees the same
+    sequence it would have otherwise, minus superseded values.
+
+    Used by @ref PortWriter for writes to the host and by UIs to apply
+    port events once per frame.  Copied data is 64-bit aligned.
+
+    @ingroup ui
+    @headerfile lvtk/port_events.hpp
+ */
+class PortQueue final {
+public:
+    PortQueue() = default;
+
+    /** Queue a control value, replacing one still pending for the port */
+    void push (uint32_t port, float value) {
+        ++total;
+        if (port < slots.size() && slots[port] >= 0) {
+            queue[(size_t) slots[port]].value = value;
+            ++merged;
+            return;
+        }
+
+        if (port >= slots.size())
+            slots.resize (port + 1, -1);
+        slots[port] = (int32_t) queue.size();
+        dirty.push_back (port);
+        queue.push_back ({ port, 0, sizeof (float), true, value, 0 });
+    }
+
+    /** Queue a port event. Float protocol values are coalesced, anything
+        else is copied */
+    void push (uint32_t port, uint32_t size, uint32_t format, const void* data) {
+        if (format == 0 && size == sizeof (float)) {
+            float value;
+            std::memcpy (&value, data, sizeof (float));
+            push (port, value);
+            return;
+        }
+
+        ++total;
+        fence();
+        // atoms must be 64-bit aligned
+        const auto offset = (bytes.size() + 7) & ~(size_t) 7;
+        bytes.resize (offset);
+        queue.push_back ({ port, format, size, false, 0.f, (uint32_t) offset });
+        const auto p = static_cast<const uint8_t*> (data);
+        bytes.insert (bytes.end(), p, p + size);
+    }
+
+    /** Pass everything queued to `fn` and empty the queue.
+
+        Anything pushed from `fn` is kept for the next flush.
+
+        @param fn   Called as fn (port, size, format, data)
+     */
+    template <typename Fn>
+    void flush (Fn&& fn) {
+        if (queue.empty())
+            return;
+
+        std::swap (queue, sending);
+        std::swap (bytes, sending_bytes);
+        fence();
+        for (const auto& e : sending) {
+            fn (e.port, e.size, e.format,
+                e.control ? (const void*) &e.value : sending_bytes.data() + e.offset);
+            ++sent;
+        }
+        sending.clear();
+        sending_bytes.clear();
+    }
+
+    /** Drop everything queued */
+    void clear() {
+        queue.clear();
+        bytes.clear();
+        fence();
+    }
+
+    /** @returns the number of entries waiting for `flush` */
+    size_t size() const noexcept { return queue.size(); }
+    /** @returns true if nothing is waiting */
+    bool empty() const noexcept { return queue.empty(); }
+    /** @returns the number of pushes */
+    uint64_t pushed() const noexcept { return total; }
+    /** @returns the number of entries passed on by `flush` */
+    uint64_t flushed() const noexcept { return sent; }
+    /** @returns the number of values replaced by a later one */
+    uint64_t saved() const noexcept { return merged; }
+
+    /** Zero the counters */
+    void reset_counters() noexcept { total = sent = merged = 0; }
+
+private:
+    struct Entry {
+        uint32_t port;
+        uint32_t format;
+        uint32_t size;
+        bool control;
+        float value;
+        uint32_t offset;
+    };
+
+    std::vector<Entry> queue, sending;
+    std::vector<uint8_t> bytes, sending_bytes;
+    std::vector<int32_t> slots;
+    std::vector<uint32_t> dirty;
+    uint64_t total = 0, sent = 0, merged = 0;
+
+    /** Stop coalescing with values queued so far */
+    void fence() noexcept {
+        for (auto port : dirty)
+            slots[port] = -1;
+        dirty.clear();
+    }
+};
+
+/** A table of port event handlers for UIs.
+
+    Binds ports to typed handlers instead of checking port indices and
+    formats in one big port_event.  Handlers are kept in a vector indexed
+    by port, so dispatch is one lookup and call.  Float values, atoms and
+    peak data are decoded before the handler is called.
+
+    Ports can be bound by symbol if the host provides LV2_UI__portMap.
+
+    @code
+        events.on_control ("volume", [this] (float db) { slider.set_value (db); });
+        events.on_atom (notify_port, [this] (const LV2_Atom& atom) { ... });
+        events.on_peak ("meter", [this] (const LV2UI_Peak_Data& p) { meter.set_peak (p.peak); });
+    @endcode
+
+    @ingroup ui
+    @headerfile lvtk/port_events.hpp
+ */
+class PortEvents final {
+public:
+    using ControlFunction = std::function<void (float)>;
+    using AtomFunction = std::function<void (const LV2_Atom&)>;
+    using PeakFunction = std::function<void (const LV2UI_Peak_Data&)>;
+    using EventFunction = std::function<void (uint32_t size, uint32_t format, const void* data)>;
+
+    PortEvents() = default;
+    explicit PortEvents (const FeatureList& features) { set_features (features); }
+
+    /** Use URID map and port map features from this list */
+    void set_features (const FeatureList& features) {
+        Map map;
+        for (const auto& f : features) {
+            if (! map)
+                map.set (f);
+            if (! port_index)
+                port_index.set (f);
+        }
+
+        if (map) {
+            event_transfer = map (LV2_ATOM__eventTransfer);
+            atom_transfer = map (LV2_ATOM__atomTransfer);
+            peak_protocol = map (LV2_UI__peakProtocol);
+        }
+    }
+
+    /** Handle float values written to a control port */
+    void on_control (uint32_t port, ControlFunction handler) { slot (port).control = std::move (handler); }
+
+    /** Handle atoms from the eventTransfer or atomTransfer protocols */
+    void on_atom (uint32_t port, AtomFunction handler) { slot (port).atom = std::move (handler); }
+
+    /** Handle peakProtocol data */
+    void on_peak (uint32_t port, PeakFunction handler) { slot (port).peak = std::move (handler); }
+
+    /** Handle anything the typed handlers of a port don't */
+    void on_event (uint32_t port, EventFunction handler) { slot (port).event = std::move (handler); }
+
+    /** Bind by symbol. @returns false if the symbol isn't known */
+    bool on_control (const std::string& symbol, ControlFunction handler) {
+        return bind (symbol, [&] (uint32_t port) { on_control (port, std::move (handler)); });
+    }
+
+    /** Bind by symbol. @returns false if the symbol isn't known */
+    bool on_atom (const std::string& symbol, AtomFunction handler) {
+        return bind (symbol, [&] (uint32_t port) { on_atom (port, std::move (handler)); });
+    }
+
+    /** Bind by symbol. @returns false if the symbol isn't known */
+    bool on_peak (const std::string& symbol, PeakFunction handler) {
+        return bind (symbol, [&] (uint32_t port) { on_peak (port, std::move (handler)); });
+    }
+
+    /** Bind by symbol. @returns false if the symbol isn't known */
+    bool on_event (const std::string& symbol, EventFunction handler) {
+        return bind (symbol, [&] (uint32_t port) { on_event (port, std::move (handler)); });
+    }
+
+    /** Remove all handlers of a port */
+    void remove (uint32_t port) {
+        if (port < slots.size())
+            slots[port] = {};
+    }
+
+    /** Remove all handlers */
+    void clear() { slots.clear(); }
+
+    /** Call the handler for a port event.
+        @returns true if a handler was called
+     */
+    bool dispatch (uint32_t port, uint32_t size, uint32_t format, const void* data) const {
+        if (port >= slots.size())
+            return false;
+
+        const auto& s = slots[port];
+        if (format == 0) {
+            if (s.control && size == sizeof (float)) {
+                float value;
+                std::memcpy (&value, data, sizeof (float));
+                s.control (value);
+                return true;
+            }
+        } else if (format == event_transfer || format == atom_transfer) {
+            // the body must fit too, handlers trust atom.size
+            const auto atom = static_cast<const LV2_Atom*> (data);
+            if (s.atom && size >= sizeof (LV2_Atom)
+                && size - sizeof (LV2_Atom) >= atom->size) {
+                s.atom (*atom);
+                return true;
+            }
+        } else if (format == peak_protocol) {
+            if (s.peak && size >= sizeof (LV2UI_Peak_Data)) {
+                s.peak (*static_cast<const LV2UI_Peak_Data*> (data));
+                return true;
+            }
+        }
+
+        if (s.event) {
+            s.event (size, format, data);
+            return true;
+        }
+
+        return false;
+    }
+
+    /** @returns the index of a port symbol, or LV2UI_INVALID_PORT_INDEX */
+    uint32_t index (const std::string& symbol) const { return port_index (symbol); }
+
+private:
+    struct Slot {
+        ControlFunction control;
+        AtomFunction atom;
+        PeakFunction peak;
+        EventFunction event;
+    };
+
+    std::vector<Slot> slots;
+    PortIndex port_index;
+    uint32_t event_transfer = 0;
+    uint32_t atom_transfer = 0;
+    uint32_t peak_protocol = 0;
+
+    Slot& slot (uint32_t port) {
+        if (port >= slots.size())
+            slots.resize (port + 1);
+        return slots[port];
+    }
+
+    template <typename Fn>
+    bool bind (const std::string& symbol, Fn&& fn) {
+        const auto port = port_index (symbol);
+        if (port == LV2UI_INVALID_PORT_INDEX)
+            return false;
+        fn (port);
+        return true;
+    }
+};
+
+} // namespace lvtk
@@ -0,0 +1,156 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace lvtk {
+
+/** A lock-free, single producer / single consumer ring buffer.
+
+    Reads and writes are wait-free and never allocate, so one end may be used
+    from the audio thread.  Writes are all-or-nothing; a write that does not
+    fit fails and leaves the buffer untouched.
+
+    Capacity is rounded up to the next power of two.  One byte is always
+    kept free to distinguish full from empty.
+
+    @headerfile lvtk/ring_buffer.hpp
+    @ingroup lvtk
+ */
+class RingBuffer final {
+public:
+    /** Create a ring buffer.
+        @param size Requested capacity in bytes
+     */
+    explicit RingBuffer (uint32_t size) {
+        capacity = 1;
+        while (capacity < size)
+            capacity <<= 1;
+        mask = capacity - 1;
+        buffer = (uint8_t*) std::malloc (capacity);
+    }
+
+    ~RingBuffer() {
+        std::free (buffer);
+        buffer = nullptr;
+    }
+
+    /** Returns the total capacity in bytes */
+    uint32_t size() const noexcept { return capacity; }
+
+    /** Returns the number of bytes available for reading. Consumer only. */
+    uint32_t read_space() const noexcept {
+        const auto w = write_pos.load (std::memory_order_acquire);
+        const auto r = read_pos.load (std::memory_order_relaxed);
+        return (w - r) & mask;
+    }
+
+    /** Returns the number of bytes available for writing. Producer only. */
+    uint32_t write_space() const noexcept {
+        const auto w = write_pos.load (std::memory_order_relaxed);
+        const auto r = read_pos.load (std::memory_order_acquire);
+        return (r - w - 1) & mask;
+    }
+
+    /** Write data.
+        @returns true if all of `size` was written
+     */
+    bool write (const void* data, uint32_t size) noexcept {
+        return write (data, size, nullptr, 0);
+    }
+
+    /** Write a header and body as a single unit.
+
+        The reader will never see the header without the body.  Useful for
+        size-prefixed messages.
+
+        @returns true if both parts were written
+     */
+    bool write (const void* head, uint32_t head_size,
+                const void* body, uint32_t body_size) noexcept {
+        // sum in 64 bits so oversized parts can't wrap past the check
+        if ((uint64_t) write_space() < (uint64_t) head_size + body_size)
+            return false;
+        auto w = write_pos.load (std::memory_order_relaxed);
+        w = copy_in (w, head, head_size);
+        w = copy_in (w, body, body_size);
+        write_pos.store (w, std::memory_order_release);
+        return true;
+    }
+
+    /** Copy data without consuming it.
+        @returns true if `size` bytes were available
+     */
+    bool peek (void* dst, uint32_t size) const noexcept {
+        if (read_space() < size)
+            return false;
+        copy_out (read_pos.load (std::memory_order_relaxed), dst, size);
+        return true;
+    }
+
+    /** Read and consume data.
+        @returns true if `size` bytes were read
+     */
+    bool read (void* dst, uint32_t size) noexcept {
+        if (! peek (dst, size))
+            return false;
+        return skip (size);
+    }
+
+    /** Consume data without copying it.
+        @returns true if `size` bytes were skipped
+     */
+    bool skip (uint32_t size) noexcept {
+        if (read_space() < size)
+            return false;
+        const auto r = read_pos.load (std::memory_order_relaxed);
+        read_pos.store ((r + size) & mask, std::memory_order_release);
+        return true;
+    }
+
+    /** Discard everything.  Only safe when neither end is in use. */
+    void reset() noexcept {
+        write_pos.store (0);
+        read_pos.store (0);
+    }
+
+private:
+    uint8_t* buffer = nullptr;
+    uint32_t capacity = 0;
+    uint32_t mask = 0;
+    std::atomic<uint32_t> write_pos { 0 };
+    std::atomic<uint32_t> read_pos { 0 };
+
+    RingBuffer (const RingBuffer&) = delete;
+    RingBuffer& operator= (const RingBuffer&) = delete;
+
+    uint32_t copy_in (uint32_t w, const void* src, uint32_t size) noexcept {
+        if (size == 0)
+            return w;
+        const uint32_t first = capacity - w;
+        if (size <= first) {
+            std::memcpy (buffer + w, src, size);
+        } else {
+            std::memcpy (buffer + w, src, first);
+            std::memcpy (buffer, (const uint8_t*) src + first, size - first);
+        }
+        return (w + size) & mask;
+    }
+
+    void copy_out (uint32_t r, void* dst, uint32_t size) const noexcept {
+        const uint32_t first = capacity - r;
+        if (size <= first) {
+            std::memcpy (dst, buffer + r, size);
+        } else {
+            std::memcpy (dst, buffer + r, first);
+            std::memcpy ((uint8_t*) dst + first, buffer, size - first);
+        }
+    }
+};
+
+} // namespace lvtk
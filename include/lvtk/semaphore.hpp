@@ -0,0 +1,99 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#if defined(__APPLE__)
+    #include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+    #include <limits.h>
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <semaphore.h>
+#endif
+
+namespace lvtk {
+
+/** A counting semaphore.
+
+    `post()` is safe to call from the audio thread. It never blocks and
+    never allocates.  Used to wake non-realtime threads such as the one in
+    @ref WorkerThread.
+
+    @headerfile lvtk/semaphore.hpp
+    @ingroup lvtk
+ */
+class Semaphore final {
+public:
+    /** Create a semaphore with an initial count */
+    explicit Semaphore (unsigned int initial = 0) {
+#if defined(__APPLE__)
+        sem = dispatch_semaphore_create (initial);
+#elif defined(_WIN32)
+        sem = CreateSemaphore (nullptr, initial, LONG_MAX, nullptr);
+#else
+        sem_init (&sem, 0, initial);
+#endif
+    }
+
+    ~Semaphore() {
+#if defined(__APPLE__)
+        dispatch_release (sem);
+#elif defined(_WIN32)
+        CloseHandle (sem);
+#else
+        sem_destroy (&sem);
+#endif
+    }
+
+    /** Increment the count and wake one waiter. */
+    void post() noexcept {
+#if defined(__APPLE__)
+        dispatch_semaphore_signal (sem);
+#elif defined(_WIN32)
+        ReleaseSemaphore (sem, 1, nullptr);
+#else
+        sem_post (&sem);
+#endif
+    }
+
+    /** Block until the count is positive, then decrement it. */
+    void wait() noexcept {
+#if defined(__APPLE__)
+        dispatch_semaphore_wait (sem, DISPATCH_TIME_FOREVER);
+#elif defined(_WIN32)
+        WaitForSingleObject (sem, INFINITE);
+#else
+        while (sem_wait (&sem) != 0 && errno == EINTR) {
+        }
+#endif
+    }
+
+    /** Decrement the count if positive without blocking.
+        @returns true if the count was decremented
+     */
+    bool try_wait() noexcept {
+#if defined(__APPLE__)
+        return 0 == dispatch_semaphore_wait (sem, DISPATCH_TIME_NOW);
+#elif defined(_WIN32)
+        return WAIT_OBJECT_0 == WaitForSingleObject (sem, 0);
+#else
+        return 0 == sem_trywait (&sem);
+#endif
+    }
+
+private:
+#if defined(__APPLE__)
+    dispatch_semaphore_t sem;
+#elif defined(_WIN32)
+    HANDLE sem;
+#else
+    sem_t sem;
+#endif
+
+    Semaphore (const Semaphore&) = delete;
+    Semaphore& operator= (const Semaphore&) = delete;
+};
+
+} // namespace lvtk
@@ -0,0 +1,409 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <lv2/state/state.h>
+#include <lv2/urid/urid.h>
+#include <lvtk/ext/state.hpp>
+#include <lvtk/mapped_file.hpp>
+
+namespace lvtk {
+
+/** An in-memory set of state values.
+
+    Hosts can pass `store_function` and `retrieve_function` with a pointer
+    to the archive straight to a plugin's save and restore.  Plugins can
+    use `get_store()` and `get_retrieve()` wherever a @ref StateStore or
+    @ref StateRetrieve is expected.
+
+    Records are packed one after another in a single flat buffer and found
+    through an open addressing index, so lookups by key are O(1) and
+    copying an archive is two memcpys.  Copy an archive to snapshot it,
+    e.g. for A/B comparison.
+
+    Archives can be written to and read from a compact binary format.  Keys
+    and types are written as URIs so files are portable between hosts.
+
+    @code
+        lvtk::StateArchive a;
+        iface->save (handle, lvtk::StateArchive::store_function, &a, LV2_STATE_IS_POD, features);
+        lvtk::StateArchive b = a;   // snapshot
+        ...
+        iface->restore (handle, lvtk::StateArchive::retrieve_function, &b, 0, features);
+    @endcode
+
+    @headerfile lvtk/state_archive.hpp
+    @ingroup state
+ */
+class StateArchive final {
+public:
+    StateArchive() = default;
+    StateArchive (const StateArchive&) = default;
+    StateArchive (StateArchive&&) = default;
+    StateArchive& operator= (const StateArchive&) = default;
+    StateArchive& operator= (StateArchive&&) = default;
+
+    /** Store a value, replacing any value with the same key.
+        @returns LV2_STATE_ERR_UNKNOWN if key is zero, or
+                 LV2_STATE_ERR_NO_SPACE if the value doesn't fit the
+                 archive's 32-bit sizes and offsets
+     */
+    LV2_State_Status store (uint32_t key, const void* value, size_t size,
+                            uint32_t type, uint32_t flags) {
+        if (key == 0 || (size > 0 && value == nullptr))
+            return LV2_STATE_ERR_UNKNOWN;
+        if (size > max_size)
+            return LV2_STATE_ERR_NO_SPACE;
+
+        const uint32_t slot = find_slot (key);
+        if (occupied (index[slot])) {
+            Record& r = record (index[slot] - 1);
+            if (size <= r.capacity) {
+                r.type = type;
+                r.flags = flags;
+                r.size = (uint32_t) size;
+                if (size > 0)
+                    std::memcpy (body (r), value, size);
+                return LV2_STATE_SUCCESS;
+            }
+
+            // doesn't fit: orphan the old record and append a new one
+            if (! can_append (size))
+                return LV2_STATE_ERR_NO_SPACE;
+            garbage += sizeof (Record) + r.capacity;
+            r.key = 0;
+            index[slot] = append (key, value, size, type, flags) + 1;
+            if (garbage > arena.size() / 2)
+                compact();
+            return LV2_STATE_SUCCESS;
+        }
+
+        if (! can_append (size))
+            return LV2_STATE_ERR_NO_SPACE;
+        if (index[slot] == tombstone)
+            --tombstones;
+        index[slot] = append (key, value, size, type, flags) + 1;
+        ++count;
+        if ((count + tombstones) * 4 >= (uint32_t) index.size() * 3)
+            rehash ((uint32_t) index.size() * 2);
+        return LV2_STATE_SUCCESS;
+    }
+
+    /** Get a value.
+        The pointer is valid until the archive is next modified.
+        @returns the value, or nullptr if not found
+     */
+    const void* retrieve (uint32_t key, size_t* size = nullptr,
+                          uint32_t* type = nullptr, uint32_t* flags = nullptr) const {
+        if (count == 0 || key == 0)
+            return nullptr;
+        const uint32_t offset = index[find_slot (key)];
+        if (! occupied (offset))
+            return nullptr;
+        const Record& r = record (offset - 1);
+        if (size != nullptr)
+            *size = r.size;
+        if (type != nullptr)
+            *type = r.type;
+        if (flags != nullptr)
+            *flags = r.flags;
+        return body (r);
+    }
+
+    /** @returns true if a value exists for `key` */
+    bool contains (uint32_t key) const { return retrieve (key) != nullptr; }
+
+    /** Remove a value.
+        @returns true if a value was removed
+     */
+    bool remove (uint32_t key) {
+        if (count == 0 || key == 0)
+            return false;
+        const uint32_t slot = find_slot (key);
+        if (! occupied (index[slot]))
+            return false;
+        Record& r = record (index[slot] - 1);
+        garbage += sizeof (Record) + r.capacity;
+        r.key = 0;
+        index[slot] = tombstone;
+        ++tombstones;
+        --count;
+        if (garbage > arena.size() / 2)
+            compact();
+        return true;
+    }
+
+    /** Remove everything. Keeps allocated memory for reuse. */
+    void clear() noexcept {
+        arena.clear();
+        std::fill (index.begin(), index.end(), 0u);
+        count = tombstones = 0;
+        garbage = 0;
+    }
+
+    /** @returns the number of values */
+    size_t size() const noexcept { return count; }
+
+    /** @returns true if there are no values */
+    bool empty() const noexcept { return count == 0; }
+
+    /** @returns the number of bytes used by records */
+    size_t bytes() const noexcept { return arena.size() - garbage; }
+
+    /** Call `fn (key, data, size, type, flags)` for every value, in the
+        order they are laid out in memory.
+     */
+    template <class Fn>
+    void for_each (Fn&& fn) const {
+        for (size_t offset = 0; offset < arena.size();) {
+            const Record& r = record ((uint32_t) offset);
+            if (r.key != 0)
+                fn (r.key, (const void*) body (r), (size_t) r.size, r.type, r.flags);
+            offset += sizeof (Record) + r.capacity;
+        }
+    }
+
+    /** Copy every value from another archive into this one. */
+    void merge (const StateArchive& other) {
+        other.for_each ([this] (uint32_t key, const void* data, size_t size, uint32_t type, uint32_t flags) {
+            store (key, data, size, type, flags);
+        });
+    }
+
+    /** @returns a StateStore which writes to this archive */
+    StateStore get_store() { return StateStore (store_function, this); }
+
+    /** @returns a StateRetrieve which reads from this archive */
+    StateRetrieve get_retrieve() const { return StateRetrieve (retrieve_function, const_cast<StateArchive*> (this)); }
+
+    /** LV2_State_Store_Function. Pass a StateArchive* as the handle. */
+    static LV2_State_Status store_function (LV2_State_Handle handle, uint32_t key,
+                                            const void* value, size_t size,
+                                            uint32_t type, uint32_t flags) {
+        return static_cast<StateArchive*> (handle)->store (key, value, size, type, flags);
+    }
+
+    /** LV2_State_Retrieve_Function. Pass a StateArchive* as the handle. */
+    static const void* retrieve_function (LV2_State_Handle handle, uint32_t key,
+                                          size_t* size, uint32_t* type, uint32_t* flags) {
+        return static_cast<const StateArchive*> (handle)->retrieve (key, size, type, flags);
+    }
+
+    /** Serialize to bytes.
+        @param unmap    Used to write keys and types as URIs
+        @returns the bytes, or empty if a URID couldn't be unmapped
+     */
+    std::vector<uint8_t> serialize (const LV2_URID_Unmap& unmap) const {
+        std::vector<uint8_t> out;
+        out.insert (out.end(), magic, magic + sizeof (magic));
+        put (out, (uint64_t) count);
+
+        bool ok = true;
+        for_each ([&] (uint32_t key, const void* data, size_t size, uint32_t type, uint32_t flags) {
+            const char* key_uri = unmap.unmap (unmap.handle, key);
+            const char* type_uri = type != 0 ? unmap.unmap (unmap.handle, type) : "";
+            if (key_uri == nullptr || type_uri == nullptr) {
+                ok = false;
+                return;
+            }
+            put_string (out, key_uri);
+            put_string (out, type_uri);
+            put (out, (uint64_t) flags);
+            put (out, (uint64_t) size);
+            const auto* bytes = static_cast<const uint8_t*> (data);
+            out.insert (out.end(), bytes, bytes + size);
+        });
+
+        if (! ok)
+            out.clear();
+        return out;
+    }
+
+    /** Replace the contents with serialized bytes.
+        @param data     Bytes produced by `serialize`
+        @param size     Number of bytes
+        @param map      Used to map keys and types
+        @returns false if the data is invalid. The archive is unchanged.
+     */
+    bool deserialize (const void* data, size_t size, const LV2_URID_Map& map) {
+        const auto* p = static_cast<const uint8_t*> (data);
+        const uint8_t* const end = p + size;
+        uint64_t n = 0;
+        if (size < sizeof (magic) || std::memcmp (p, magic, sizeof (magic)) != 0)
+            return false;
+        p += sizeof (magic);
+        if (! get (p, end, n))
+            return false;
+
+        StateArchive loaded;
+        std::string key_uri, type_uri;
+        for (uint64_t i = 0; i < n; ++i) {
+            uint64_t flags = 0, length = 0;
+            if (! get_string (p, end, key_uri) || ! get_string (p, end, type_uri)
+                || ! get (p, end, flags) || ! get (p, end, length)
+                || length > (uint64_t) (end - p))
+                return false;
+            const uint32_t type = type_uri.empty() ? 0 : map.map (map.handle, type_uri.c_str());
+            loaded.store (map.map (map.handle, key_uri.c_str()), p, (size_t) length, type, (uint32_t) flags);
+            p += length;
+        }
+
+        *this = std::move (loaded);
+        return true;
+    }
+
+    /** Write to a binary file.
+        @returns true on success
+     */
+    bool write_file (const char* path, const LV2_URID_Unmap& unmap) const {
+        const auto bytes = serialize (unmap);
+        if (bytes.empty())
+            return false;
+        FILE* file = std::fopen (path, "wb");
+        if (file == nullptr)
+            return false;
+        const bool written = std::fwrite (bytes.data(), 1, bytes.size(), file) == bytes.size();
+        return std::fclose (file) == 0 && written;
+    }
+
+    /** Read from a binary file written by `write_file`.
+        @returns true on success. The archive is unchanged on failure.
+     */
+    bool read_file (const char* path, const LV2_URID_Map& map) {
+        MappedFile file (path);
+        return file && deserialize (file.data(), file.size(), map);
+    }
+
+private:
+    struct Record {
+        uint32_t key;
+        uint32_t type;
+        uint32_t flags;
+        uint32_t size;
+        uint32_t capacity;
+        uint32_t reserved;
+    };
+
+    static constexpr uint8_t magic[8] = { 'l', 'v', 't', 'k', 's', 't', 'a', '1' };
+    static constexpr uint32_t tombstone = UINT32_MAX;
+    static constexpr size_t alignment = 8;
+    // largest value whose aligned capacity fits a Record
+    static constexpr size_t max_size = UINT32_MAX & ~(alignment - 1);
+
+    std::vector<uint8_t> arena;
+    std::vector<uint32_t> index = std::vector<uint32_t> (16, 0u); // record offset + 1
+    uint32_t count = 0;
+    uint32_t tombstones = 0;
+    size_t garbage = 0;
+
+    Record& record (uint32_t offset) { return *reinterpret_cast<Record*> (arena.data() + offset); }
+    const Record& record (uint32_t offset) const { return *reinterpret_cast<const Record*> (arena.data() + offset); }
+    uint8_t* body (Record& r) { return reinterpret_cast<uint8_t*> (&r + 1); }
+    const uint8_t* body (const Record& r) const { return reinterpret_cast<const uint8_t*> (&r + 1); }
+
+    static uint32_t hash (uint32_t key) noexcept { return key * 2654435761u; }
+    static bool occupied (uint32_t v) noexcept { return v != 0 && v != tombstone; }
+
+    /** Slot holding `key`, or the empty slot where it would go */
+    uint32_t find_slot (uint32_t key) const noexcept {
+        const uint32_t mask = (uint32_t) index.size() - 1;
+        uint32_t slot = hash (key) & mask;
+        uint32_t insert = UINT32_MAX;
+        for (;;) {
+            const uint32_t v = index[slot];
+            if (v == 0)
+                return insert != UINT32_MAX ? insert : slot;
+            if (v == tombstone) {
+                if (insert == UINT32_MAX)
+                    insert = slot;
+            } else if (record (v - 1).key == key) {
+                return slot;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    /** @returns true if the arena can grow by a record of size without its
+        offsets reaching the index's tombstone */
+    bool can_append (size_t size) const noexcept {
+        const uint64_t capacity = ((uint64_t) size + alignment - 1) & ~(uint64_t) (alignment - 1);
+        return (uint64_t) arena.size() + sizeof (Record) + capacity < tombstone;
+    }
+
+    uint32_t append (uint32_t key, const void* value, size_t size, uint32_t type, uint32_t flags) {
+        const size_t capacity = (size + alignment - 1) & ~(alignment - 1);
+        const auto offset = (uint32_t) arena.size();
+        arena.resize (arena.size() + sizeof (Record) + capacity);
+        Record& r = record (offset);
+        r = { key, type, flags, (uint32_t) size, (uint32_t) capacity, 0 };
+        if (size > 0)
+            std::memcpy (body (r), value, size);
+        return offset;
+    }
+
+    void rehash (uint32_t slots) {
+        index.assign (slots, 0u);
+        tombstones = 0;
+        for (size_t offset = 0; offset < arena.size();) {
+            const Record& r = record ((uint32_t) offset);
+            if (r.key != 0)
+                index[find_slot (r.key)] = (uint32_t) offset + 1;
+            offset += sizeof (Record) + r.capacity;
+        }
+    }
+
+    void compact() {
+        std::vector<uint8_t> packed;
+        packed.reserve (arena.size() - garbage);
+        for (size_t offset = 0; offset < arena.size();) {
+            const Record& r = record ((uint32_t) offset);
+            const size_t length = sizeof (Record) + r.capacity;
+            if (r.key != 0)
+                packed.insert (packed.end(), arena.begin() + offset, arena.begin() + offset + length);
+            offset += length;
+        }
+        arena.swap (packed);
+        garbage = 0;
+        rehash ((uint32_t) index.size());
+    }
+
+    static void put (std::vector<uint8_t>& out, uint64_t v) {
+        for (int i = 0; i < 8; ++i)
+            out.push_back ((uint8_t) (v >> (8 * i)));
+    }
+
+    static void put_string (std::vector<uint8_t>& out, const char* str) {
+        const size_t length = std::strlen (str);
+        put (out, (uint64_t) length);
+        out.insert (out.end(), str, str + length);
+    }
+
+    static bool get (const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        if (end - p < 8)
+            return false;
+        v = 0;
+        for (int i = 0; i < 8; ++i)
+            v |= (uint64_t) p[i] << (8 * i);
+        p += 8;
+        return true;
+    }
+
+    static bool get_string (const uint8_t*& p, const uint8_t* end, std::string& str) {
+        uint64_t length = 0;
+        if (! get (p, end, length) || length > (uint64_t) (end - p))
+            return false;
+        str.assign ((const char*) p, (size_t) length);
+        p += length;
+        return true;
+    }
+};
+
+} // namespace lvtk
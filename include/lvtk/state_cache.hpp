@@ -0,0 +1,134 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <lv2/state/state.h>
+#include <lvtk/ext/state.hpp>
+#include <lvtk/state_archive.hpp>
+
+namespace lvtk {
+
+/** A host-side cache of a plugin's saved state.
+
+    Keeps the values from the previous save and passes a @ref StateSince
+    feature on the next one.  Plugins which support it only store what
+    changed, which is merged into the cache.  Plugins which don't are saved
+    in full every time, so the cache is always a complete copy of the
+    plugin's state.
+
+    @code
+        lvtk::StateCache cache;
+
+        // autosave
+        cache.save (iface, handle, LV2_STATE_IS_POD, features);
+        if (cache.changed())
+            write_session (cache.archive());
+    @endcode
+
+    @headerfile lvtk/state_cache.hpp
+    @ingroup state
+ */
+class StateCache final {
+public:
+    StateCache() = default;
+
+    /** Save a plugin's state into the cache.
+
+        @param iface    The plugin's state interface
+        @param instance The plugin instance
+        @param flags    Flags passed to the plugin's save
+        @param features Features passed to the plugin's save
+        @returns the plugin's status. The cache is unchanged on failure.
+     */
+    LV2_State_Status save (const LV2_State_Interface* iface, LV2_Handle instance,
+                           uint32_t flags, const LV2_Feature* const* features) {
+        if (iface == nullptr || iface->save == nullptr)
+            return LV2_STATE_ERR_NO_FEATURE;
+
+        StateSince since;
+        since.since = last_generation;
+        const LV2_Feature since_feature = { LVTK_STATE__since, &since };
+
+        std::vector<const LV2_Feature*> all;
+        if (features != nullptr)
+            for (auto f = features; *f != nullptr; ++f)
+                all.push_back (*f);
+        all.push_back (&since_feature);
+        all.push_back (nullptr);
+
+        pending.clear();
+        const auto status = iface->save (instance, StateArchive::store_function,
+                                         &pending, flags, all.data());
+        if (status != LV2_STATE_SUCCESS)
+            return status;
+
+        last_changed = ! since.incremental || ! pending.empty();
+        last_generation = since.incremental ? since.generation : 0;
+
+        if (since.incremental)
+            values.merge (pending);
+        else
+            std::swap (values, pending);
+        pending.clear();
+        return status;
+    }
+
+    /** Restore a plugin from the cache.
+
+        @param iface    The plugin's state interface
+        @param instance The plugin instance
+        @param flags    Flags passed to the plugin's restore
+        @param features Features passed to the plugin's restore
+        @returns the plugin's status
+     */
+    LV2_State_Status restore (const LV2_State_Interface* iface, LV2_Handle instance,
+                              uint32_t flags, const LV2_Feature* const* features) const {
+        if (iface == nullptr || iface->restore == nullptr)
+            return LV2_STATE_ERR_NO_FEATURE;
+        static const LV2_Feature* const none[] = { nullptr };
+        return iface->restore (instance, StateArchive::retrieve_function,
+                               const_cast<StateArchive*> (&values), flags,
+                               features != nullptr ? features : none);
+    }
+
+    /** Get a cached value.
+        @returns the value, or nullptr if not found
+     */
+    const void* get (uint32_t key, size_t* size = nullptr,
+                     uint32_t* type = nullptr, uint32_t* flags = nullptr) const {
+        return values.retrieve (key, size, type, flags);
+    }
+
+    /** @returns the cached values */
+    const StateArchive& archive() const noexcept { return values; }
+
+    /** @returns the number of cached values */
+    size_t size() const noexcept { return values.size(); }
+
+    /** @returns true if the last save changed the cache */
+    bool changed() const noexcept { return last_changed; }
+
+    /** @returns the plugin's state generation at the last save, or zero
+        if the plugin doesn't support incremental saves */
+    uint64_t generation() const noexcept { return last_generation; }
+
+    /** Empty the cache. The next save will be a full one. */
+    void clear() {
+        values.clear();
+        last_generation = 0;
+        last_changed = false;
+    }
+
+private:
+    StateArchive values;
+    StateArchive pending;
+    uint64_t last_generation = 0;
+    bool last_changed = false;
+};
+
+} // namespace lvtk
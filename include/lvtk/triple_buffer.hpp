@@ -0,0 +1,91 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace lvtk {
+
+/** A lock-free, single producer / single consumer triple buffer.
+
+    The producer always has a buffer to write and the consumer always has
+    the latest complete one to read, so neither side ever waits.  Values
+    published faster than they are read are replaced, which suits meters,
+    scopes and spectrum frames.
+
+    @code
+        // audio thread
+        auto& frame = buffer.write_buffer();
+        analyze (frame, nframes);
+        buffer.publish();
+
+        // ui thread
+        if (buffer.update())
+            draw (buffer.read_buffer());
+    @endcode
+
+    @headerfile lvtk/triple_buffer.hpp
+    @ingroup lvtk
+ */
+template <typename T>
+class TripleBuffer final {
+    static_assert (std::is_trivially_copyable<T>::value, "TripleBuffer type must be trivially copyable");
+
+public:
+    TripleBuffer() = default;
+
+    /** @returns the buffer to fill before `publish`. Producer only. */
+    T& write_buffer() noexcept { return slots[back].value; }
+
+    /** Make the write buffer the latest value. Producer only. */
+    void publish() noexcept {
+        back = middle.exchange (back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+    }
+
+    /** Copy and publish a value. Producer only. */
+    void write (const T& value) noexcept {
+        write_buffer() = value;
+        publish();
+    }
+
+    /** Take the latest value if there is a new one. Consumer only.
+        @returns true if `read_buffer` changed
+     */
+    bool update() noexcept {
+        if ((middle.load (std::memory_order_relaxed) & fresh_bit) == 0)
+            return false;
+        front = middle.exchange (front, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+
+    /** @returns the latest value taken by `update`. Consumer only. */
+    const T& read_buffer() const noexcept { return slots[front].value; }
+
+    /** Copy the latest value if there is a new one. Consumer only.
+        @returns true if `value` was set
+     */
+    bool read (T& value) noexcept {
+        if (! update())
+            return false;
+        value = read_buffer();
+        return true;
+    }
+
+private:
+    static constexpr uint32_t index_mask = 0x3;
+    static constexpr uint32_t fresh_bit = 0x4;
+
+    struct alignas (64) Slot {
+        T value {};
+    };
+
+    Slot slots[3];
+    uint32_t back = 0;
+    alignas (64) std::atomic<uint32_t> middle { 1 };
+    alignas (64) uint32_t front = 2;
+};
+
+} // namespace lvtk
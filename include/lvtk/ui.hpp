@@ -12,9 +12,15 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include <lv2/ui/ui.h>
 #include <lvtk/lvtk.hpp>
-#include <memory>
+#include <lvtk/port_events.hpp>
 
 namespace lvtk {
 /** Vector of LV2UI_Descriptor's
@@ -70,6 +76,57 @@ private:
     LV2UI_Write_Function port_write = nullptr;
 };
 
+/** Coalesces port writes to a @ref Controller
+
+    Keeps only the latest value written to each control port until
+    `flush` is called, so a knob drag sends one write per frame instead
+    of one per mouse event.  Writes with any other protocol, e.g. atom
+    events, are sent in order.  See @ref PortQueue.
+
+    @ingroup ui
+    @headerfile lvtk/ui.hpp
+ */
+class PortWriter final {
+public:
+    PortWriter() = default;
+    explicit PortWriter (const Controller& c) : controller (c) {}
+
+    /** Queue a control value, replacing one still pending for the port */
+    void write (uint32_t port, float value) { queue.push (port, value); }
+
+    /** Queue a write. Float protocol writes are coalesced, anything else
+        is copied and sent in order */
+    void write (uint32_t port, uint32_t size, uint32_t protocol, const void* data) {
+        queue.push (port, size, protocol, data);
+    }
+
+    /** Send everything pending to the host */
+    void flush() {
+        queue.flush ([this] (uint32_t port, uint32_t size, uint32_t protocol, const void* data) {
+            controller.write (port, size, protocol, data);
+        });
+    }
+
+    /** Drop everything pending */
+    void clear() { queue.clear(); }
+
+    /** @returns the number of writes waiting for `flush` */
+    size_t pending() const noexcept { return queue.size(); }
+    /** @returns the number of writes made */
+    uint64_t writes() const noexcept { return queue.pushed(); }
+    /** @returns the number of writes sent to the host */
+    uint64_t flushed() const noexcept { return queue.flushed(); }
+    /** @returns the number of writes replaced by a later value */
+    uint64_t saved() const noexcept { return queue.saved(); }
+
+    /** Zero the counters */
+    void reset_counters() noexcept { queue.reset_counters(); }
+
+private:
+    Controller controller;
+    PortQueue queue;
+};
+
 /** Parameters passed to UI instances
     @headerfile lvtk/ui.hpp
     @ingroup ui
@@ -151,7 +208,9 @@ protected:
     /** A UI with Arguments */
     explicit UI (const UIArgs& args)
         : E<S> (args.features)...,
-          controller (args.controller) {}
+          controller (args.controller),
+          writer (args.controller),
+          events (args.features) {}
 
 public:
     virtual ~UI() = default;
@@ -174,8 +233,40 @@ public:
      
         Called when port events are received from the host. Implement this to 
         update the UI when properties change in the plugin.
+
+        The default calls handlers bound with `port_events()`.
     */
-    void port_event (uint32_t port, uint32_t size, uint32_t format, const void* data) {}
+    void port_event (uint32_t port, uint32_t size, uint32_t format, const void* data) {
+        events.dispatch (port, size, format, data);
+    }
+
+    /** Port event handlers used by the default `port_event` */
+    PortEvents& port_events() noexcept { return events; }
+
+    /** Enable or disable deferred port events. Disabled by default.
+
+        When enabled, events from the host are queued instead of calling
+        `port_event` right away, and `apply_port_events` passes them on.
+        Only the latest value of each control port is kept, so a meter
+        updated many times between frames is handled once.  The @ref Idle
+        extension applies events before each call to `idle()`, UIs without
+        it should call `apply_port_events` once per frame.
+     */
+    void set_deferred_port_events (bool enabled) {
+        if (! enabled)
+            apply_port_events();
+        defer_events = enabled;
+    }
+
+    /** Call `port_event` for each deferred event */
+    void apply_port_events() {
+        incoming.flush ([this] (uint32_t port, uint32_t size, uint32_t format, const void* data) {
+            static_cast<S*> (this)->port_event (port, size, format, data);
+        });
+    }
+
+    /** @returns the queue of deferred port events, e.g. for its counters */
+    const PortQueue& deferred_port_events() const noexcept { return incoming; }
 
     /** Write data to ports
         
@@ -185,14 +276,39 @@ public:
         @param data
      */
     inline void write (uint32_t port, uint32_t size, uint32_t protocol, const void* data) const {
-        controller.write (port, size, protocol, data);
+        if (coalesce)
+            writer.write (port, size, protocol, data);
+        else
+            controller.write (port, size, protocol, data);
     }
 
     /** Write a float to a control port */
     inline void write (uint32_t port, float value) const {
-        write (port, sizeof (float), 0, &value);
+        if (coalesce)
+            writer.write (port, value);
+        else
+            controller.write (port, sizeof (float), 0, &value);
     }
 
+    /** Enable or disable coalesced port writes. Disabled by default.
+
+        When enabled, `write` queues values in a @ref PortWriter and only
+        the latest value per control port is sent on `flush_writes`.  The
+        @ref Idle extension flushes after each call to `idle()`, UIs without
+        it must call `flush_writes` themselves, e.g. once per frame.
+     */
+    void set_coalesced_writes (bool enabled) {
+        if (! enabled)
+            writer.flush();
+        coalesce = enabled;
+    }
+
+    /** Send pending coalesced writes to the host */
+    void flush_writes() { writer.flush(); }
+
+    /** @returns the writer used for coalesced writes, e.g. for its counters */
+    const PortWriter& port_writer() const noexcept { return writer; }
+
 protected:
     /** Controller access. This is handy if you want to use port-writing
         in client code, but not necessarily expose your UI class
@@ -201,6 +317,11 @@ protected:
 
 private:
     friend class UIDescriptor<S>; // so this can be private
+    mutable PortWriter writer;
+    bool coalesce = false;
+    PortEvents events;
+    PortQueue incoming;
+    bool defer_events = false;
 
     inline static ExtensionMap& extensions() {
         static ExtensionMap s_extensions;
@@ -254,7 +375,11 @@ private:
                              uint32_t buffer_size,
                              uint32_t format,
                              const void* buffer) {
-        (static_cast<S*> (ui))->port_event (port_index, buffer_size, format, buffer);
+        auto self = static_cast<S*> (ui);
+        if (self->defer_events)
+            self->incoming.push (port_index, buffer_size, format, buffer);
+        else
+            self->port_event (port_index, buffer_size, format, buffer);
     }
 
     static const void* _extension_data (const char* uri) {
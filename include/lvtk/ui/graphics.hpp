@@ -33,6 +33,8 @@ public:
     void fill_rect (const Rectangle<float>& r) { surface.fill_rect (r); }
     void fill_rect (const Rectangle<int>& r) { surface.fill_rect (r.as<float>()); }
     Bounds clip_bounds() const noexcept { return surface.clip_bounds(); }
+    /** Restrict drawing to the part of r inside the current clip */
+    void clip (const Bounds& r) { surface.set_clip_bounds (r.intersection (surface.clip_bounds())); }
 
 private:
     Surface& surface;
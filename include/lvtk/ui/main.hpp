@@ -4,6 +4,7 @@
 #pragma once
 
 #include "lvtk/context.hpp"
+#include "lvtk/ext/ui/port_subscribe.hpp"
 #include "lvtk/ui/view.hpp"
 #include "lvtk/ui/widget.hpp"
 
@@ -58,6 +59,17 @@ public:
     /** Elevate a Widget to view status */
     void elevate (Widget& widget, uintptr_t parent);
     
+    /** Set the subscriptions used by widgets watching ports.
+        Call before elevating widgets.  Widgets keep a pointer to subs
+        while they are showing and release through it when hidden or
+        destroyed, so it must outlive every Widget elevated here.
+        @see Widget::watch_port
+     */
+    void set_port_subscriptions (PortSubscriptions* subs) noexcept { _subscriptions = subs; }
+
+    /** Returns the subscriptions set by set_port_subscriptions */
+    PortSubscriptions* port_subscriptions() const noexcept { return _subscriptions; }
+
     /** Returns the underlying PuglWorld */
     uintptr_t world() const noexcept { return _world; }
 
@@ -68,6 +80,7 @@ private:
     uintptr_t _world;
     std::unique_ptr<Backend> _backend;
     const Mode _mode;
+    PortSubscriptions* _subscriptions = nullptr;
     Main() = delete;
     Main (const Main&) = delete;
     Main (Main&&) = delete;
@@ -26,7 +26,25 @@ public:
     virtual void end_frame() {}
 };
 
-/** Surf template param must be an OpenGLView of some kind */
+/** Surf template param must be an OpenGLView of some kind
+
+    Views are double buffered by default and redraw in full on every
+    expose.  A view which mostly repaints small areas, such as meters,
+    can opt in to a single buffered context so only damaged widgets are
+    painted:
+
+    @code
+        template <class Surf>
+        struct MeterView : OpenGLView<Surf> {
+            MeterView (Main& context, Widget& widget)
+                : OpenGLView<Surf> (context, widget) {
+                this->set_double_buffered (false);
+            }
+        };
+
+        auto backend = std::make_unique<OpenGL<NanoVGSurface, MeterView<NanoVGSurface>>> ("meters");
+    @endcode
+ */
 template <class Surf>
 class OpenGLView : public View {
 public:
@@ -51,18 +69,40 @@ protected:
         if (! _surface) {
             _surface = std::make_unique<Surf>();
         }
+        _double_buffered = double_buffered();
     }
 
+    /** Render the exposed area.
+
+        After a buffer swap the back buffer holds an older frame or
+        undefined contents, so a double buffered context redraws the
+        whole view and damage only decides when a frame is drawn.  A
+        single buffered context, requested with set_double_buffered,
+        keeps its pixels, so only widgets intersecting frame are painted.
+     */
     void expose (Bounds frame) {
+        const auto size = bounds();
+        const Bounds full { 0, 0, size.width, size.height };
+        frame = _double_buffered ? full : frame.intersection (full);
+        const bool partial = ! (frame == full);
+        if (partial) {
+            glEnable (GL_SCISSOR_TEST);
+            glScissor (frame.x, size.height - frame.y - frame.height, frame.width, frame.height);
+        }
+
         glClearColor (0.f, 0.f, 0.f, 1.0f);
         glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        _surface->begin_frame (frame.width, frame.height, scale());
-        render (*_surface);
+        _surface->begin_frame (size.width, size.height, scale());
+        render (*_surface, frame);
         _surface->end_frame();
+
+        if (partial)
+            glDisable (GL_SCISSOR_TEST);
     }
 
 private:
     std::unique_ptr<OpenGLSurface> _surface;
+    bool _double_buffered = true;
 };
 
 template<class Surf, class V = OpenGLView<Surf>>
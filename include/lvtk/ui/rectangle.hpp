@@ -67,7 +67,7 @@ struct Rectangle {
 
     /** Returns a copy of this shape with top-left at x y */
     Rectangle<Val> at (Val x, Val y) const noexcept {
-        return { Val(), Val(), width, height };
+        return { x, y, width, height };
     }
 
     std::string str() const noexcept {
@@ -90,12 +90,43 @@ struct Rectangle {
                && y + height >= other.y + other.height;
     }
 
+    /** True if this and other overlap */
+    bool intersects (Rectangle other) const noexcept {
+        return ! empty() && ! other.empty()
+               && x < other.x + other.width && other.x < x + width
+               && y < other.y + other.height && other.y < y + height;
+    }
+
+    /** Returns the area covered by both this and other, empty if none */
+    Rectangle<Val> intersection (Rectangle other) const noexcept {
+        const Val x1 = x > other.x ? x : other.x;
+        const Val y1 = y > other.y ? y : other.y;
+        const Val x2 = x + width < other.x + other.width ? x + width : other.x + other.width;
+        const Val y2 = y + height < other.y + other.height ? y + height : other.y + other.height;
+        if (x2 <= x1 || y2 <= y1)
+            return {};
+        return { x1, y1, x2 - x1, y2 - y1 };
+    }
+
+    /** Returns the smallest rectangle containing this and other */
+    Rectangle<Val> united (Rectangle other) const noexcept {
+        if (empty())
+            return other;
+        if (other.empty())
+            return *this;
+        const Val x1 = x < other.x ? x : other.x;
+        const Val y1 = y < other.y ? y : other.y;
+        const Val x2 = x + width > other.x + other.width ? x + width : other.x + other.width;
+        const Val y2 = y + height > other.y + other.height ? y + height : other.y + other.height;
+        return { x1, y1, x2 - x1, y2 - y1 };
+    }
+
     bool operator== (const Rectangle<Val>& o) const noexcept {
         return x == o.x && y == o.y && width == o.width && height == o.height;
     }
 
     Rectangle<Val> operator+ (Point<Val> delta) const noexcept {
-        return { x + delta.x, y + delta.y };
+        return { x + delta.x, y + delta.y, width, height };
     }
     Rectangle<Val>& operator+= (Point<Val> delta) noexcept {
         x += delta.x;
@@ -103,7 +134,7 @@ struct Rectangle {
         return *this;
     }
     Rectangle<Val> operator- (Point<Val> delta) const noexcept {
-        return { x - delta.x, y - delta.y };
+        return { x - delta.x, y - delta.y, width, height };
     }
     Rectangle<Val>& operator-= (Point<Val> delta) noexcept {
         x -= delta.x;
@@ -16,7 +16,9 @@ public:
 
     virtual void translate (const Point<int>& pt) = 0;
 
+    /** Restrict drawing to r, in the current translated coordinates */
     virtual void set_clip_bounds (const Rectangle<int>& r) = 0;
+    /** Returns the clip area in the current translated coordinates */
     virtual Rectangle<int> clip_bounds() const = 0;
 
     virtual void save() = 0;
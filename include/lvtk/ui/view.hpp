@@ -26,17 +26,32 @@ public:
     Bounds bounds() const;
 
     void realize();
+
+    /** Request a redraw of part of the view.
+        Areas requested before the next frame are merged into one expose.
+        Backends may redraw more than the requested area.
+     */
+    void repaint (Bounds area);
     
 protected:
     View (Main& context, Widget& widget);
     void render (Surface& surface);
+    /** Render only widgets intersecting area, clipped to it */
+    void render (Surface& surface, Bounds area);
     void set_backend (uintptr_t);
+    /** Request a single or double buffered context.
+        Call before the view is realized, e.g. from a subclass constructor.
+     */
+    void set_double_buffered (bool double_buffered);
+    /** True unless the realized context is known to be single buffered */
+    bool double_buffered() const;
     virtual void expose (Bounds frame) {}
     virtual void created() {}
     virtual void destroyed() {}
 
 private:
     friend class Main;
+    friend class Widget;
     Main& _main;
     Widget& _widget;
     uintptr_t _view;
@@ -12,15 +12,15 @@
 
 namespace lvtk {
 
+class PortSubscriptions;
+namespace detail {
+class WidgetGrid;
+}
+
 class Widget {
 public:
-    Widget() {
-        _weak_status.reset (this);
-    }
-
-    virtual ~Widget() {
-        _weak_status.reset (nullptr);
-    }
+    Widget();
+    virtual ~Widget();
 
     Widget* parent() const noexcept { return _parent; }
 
@@ -31,8 +31,32 @@ public:
     bool visible() const noexcept;
     void set_visible (bool visible);
 
+    /** True if this and all parents are visible in a visible View */
+    bool showing() const noexcept;
+
+    /** Receive events for a port only while this Widget is showing.
+
+        The port is subscribed through the Main's PortSubscriptions when
+        the Widget is shown in a realized View and unsubscribed when it
+        is hidden or removed, so hosts don't send events for hidden pages.
+
+        @param port     The port index
+        @param protocol Protocol URID, zero for float
+     */
+    void watch_port (uint32_t port, uint32_t protocol = 0);
+
+    /** Stop watching a port */
+    void unwatch_port (uint32_t port, uint32_t protocol = 0);
+
+    /** Redraw all of this Widget on the next frame */
     void repaint();
-    
+    /** Redraw part of this Widget on the next frame.
+        The area is in local coordinates and is clipped to this Widget and
+        its parents.  Only widgets intersecting the damaged area are
+        painted when the View renders.
+     */
+    void repaint (Bounds area);
+
     virtual void resized() {}
     virtual void paint (Graphics&) {}
     virtual void motion (InputEvent) {}
@@ -75,10 +99,22 @@ public:
 
     //=========================================================================
     /** Returns the Widget underneath the given coordinate.
+        Children added last are on top and are checked first.
         @param coord The coordinate to check in local space
      */
     Widget* widget_at (Point<float> coord);
 
+    /** Index children in a grid for hit testing.
+
+        widget_at and obstructed then only check children overlapping the
+        coordinate instead of all of them, which matters for containers
+        with hundreds of children like mixers and step sequencers.  The
+        index follows add, remove and set_bounds of the children.
+     */
+    void set_spatial_index (bool enabled);
+    /** True if children are indexed for hit testing */
+    bool spatial_index() const noexcept { return _index != nullptr; }
+
     //=========================================================================
     Widget* find_root() const noexcept;
     ViewRef find_view() const noexcept;
@@ -94,12 +130,21 @@ public:
 
 private:
     friend class Main;
+    friend class View;
     Widget* _parent = nullptr;
     std::unique_ptr<View> _view;
     std::vector<Widget*> _widgets;
     Rectangle<int> _bounds;
     bool _visible { false };
+    struct WatchedPort {
+        uint32_t port;
+        uint32_t protocol;
+    };
+    std::vector<WatchedPort> _ports;
+    PortSubscriptions* _subscriptions = nullptr;
+    std::unique_ptr<detail::WidgetGrid> _index;
     void render_internal (Graphics& g);
+    void update_subscriptions();
     LVTK_WEAK_REFABLE (Widget, _weak_status)
 };
 
@@ -0,0 +1,213 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+#include <lv2/worker/worker.h>
+#include <lvtk/ring_buffer.hpp>
+#include <lvtk/semaphore.hpp>
+
+namespace lvtk {
+
+/** A host-side worker which runs jobs on a dedicated thread.
+
+    Plugin implementations don't need to use this.  You can, however, use
+    this in an LV2 host to provide the LV2_Worker_Schedule feature to
+    plugins which use the @ref Worker mixin.
+
+    Jobs scheduled from the audio thread are written to a lock-free request
+    ring and handled by `work` on the worker thread.  Responses are written
+    to a second ring and delivered back to the plugin when the host calls
+    `emit_responses()` at the end of each run cycle.  Neither ring allocates
+    or blocks; messages that don't fit are dropped and counted.
+
+    @code
+        lvtk::WorkerThread worker;
+        const LV2_Feature* features[] = { worker.get_schedule_feature(), nullptr };
+        auto handle = desc->instantiate (desc, rate, bundle, features);
+        worker.start (desc, handle);
+
+        // audio thread
+        desc->run (handle, nframes);
+        worker.emit_responses();
+    @endcode
+
+    @headerfile lvtk/worker.hpp
+    @ingroup worker
+ */
+class WorkerThread final {
+public:
+    /** Create a worker. The thread is not started until `start` is called.
+        @param ring_size    Size in bytes of each of the request and
+                            response rings
+     */
+    explicit WorkerThread (uint32_t ring_size = 4096)
+        : requests (ring_size),
+          responses (ring_size) {
+        request_buffer = std::malloc (requests.size());
+        response_buffer = std::malloc (responses.size());
+
+        schedule_data.handle = this;
+        schedule_data.schedule_work = _schedule_work;
+        schedule_feature.URI = LV2_WORKER__schedule;
+        schedule_feature.data = &schedule_data;
+    }
+
+    ~WorkerThread() {
+        stop();
+        std::free (request_buffer);
+        std::free (response_buffer);
+    }
+
+    /** @returns a LV2_Feature with LV2_Worker_Schedule as the data member */
+    const LV2_Feature* get_schedule_feature() const { return &schedule_feature; }
+
+    /** Start the worker thread for an instance.
+        @param descriptor   Descriptor of the instance
+        @param instance     The plugin instance
+        @returns false if the plugin has no worker interface
+     */
+    bool start (const LV2_Descriptor* descriptor, LV2_Handle instance) {
+        if (descriptor == nullptr || descriptor->extension_data == nullptr)
+            return false;
+        const auto* iface = (const LV2_Worker_Interface*)
+            descriptor->extension_data (LV2_WORKER__interface);
+        return start (instance, iface);
+    }
+
+    /** Start the worker thread for an instance.
+        @param instance     The plugin instance
+        @param iface        The plugin's worker interface
+        @returns false if iface is null or already started
+     */
+    bool start (LV2_Handle instance, const LV2_Worker_Interface* iface) {
+        if (iface == nullptr || thread.joinable())
+            return false;
+        handle = instance;
+        worker = iface;
+        exit_flag.store (false);
+        thread = std::thread (&WorkerThread::process, this);
+        return true;
+    }
+
+    /** Stop the worker thread. Pending jobs are discarded. */
+    void stop() {
+        if (! thread.joinable())
+            return;
+        exit_flag.store (true);
+        sem.post();
+        thread.join();
+        requests.reset();
+        responses.reset();
+        handle = nullptr;
+        worker = nullptr;
+    }
+
+    /** @returns true if the worker thread is running */
+    bool running() const noexcept { return thread.joinable(); }
+
+    /** Schedule a job. Call from the audio thread only.
+        @returns LV2_WORKER_ERR_NO_SPACE if the request ring is full
+     */
+    LV2_Worker_Status schedule_work (uint32_t size, const void* data) noexcept {
+        if (! requests.write (&size, sizeof (size), data, size)) {
+            request_overflows.fetch_add (1, std::memory_order_relaxed);
+            return LV2_WORKER_ERR_NO_SPACE;
+        }
+        sem.post();
+        return LV2_WORKER_SUCCESS;
+    }
+
+    /** Deliver pending responses to the plugin, then call end_run.
+
+        Call this from the audio thread immediately after each call to
+        the plugin's run() method.
+     */
+    void emit_responses() noexcept {
+        if (worker == nullptr)
+            return;
+
+        uint32_t available = responses.read_space();
+        uint32_t size = 0;
+        while (available >= sizeof (size) && responses.peek (&size, sizeof (size))) {
+            if (available < sizeof (size) + size)
+                break;
+            responses.skip (sizeof (size));
+            responses.read (response_buffer, size);
+            available -= sizeof (size) + size;
+            if (worker->work_response != nullptr)
+                worker->work_response (handle, size, response_buffer);
+        }
+
+        if (worker->end_run != nullptr)
+            worker->end_run (handle);
+    }
+
+    /** @returns the number of jobs dropped because the request ring was full */
+    uint64_t dropped_requests() const noexcept { return request_overflows.load(); }
+
+    /** @returns the number of responses dropped because the response ring was full */
+    uint64_t dropped_responses() const noexcept { return response_overflows.load(); }
+
+private:
+    RingBuffer requests;
+    RingBuffer responses;
+    void* request_buffer = nullptr;
+    void* response_buffer = nullptr;
+    Semaphore sem;
+    std::thread thread;
+    std::atomic<bool> exit_flag { false };
+    std::atomic<uint64_t> request_overflows { 0 };
+    std::atomic<uint64_t> response_overflows { 0 };
+
+    LV2_Handle handle = nullptr;
+    const LV2_Worker_Interface* worker = nullptr;
+
+    LV2_Feature schedule_feature;
+    LV2_Worker_Schedule schedule_data;
+
+    WorkerThread (const WorkerThread&) = delete;
+    WorkerThread& operator= (const WorkerThread&) = delete;
+
+    void process() {
+        for (;;) {
+            sem.wait();
+            if (exit_flag.load())
+                break;
+
+            uint32_t size = 0;
+            if (! requests.read (&size, sizeof (size)))
+                continue;
+            if (! requests.read (request_buffer, size))
+                continue;
+
+            worker->work (handle, _respond, this, size, request_buffer);
+        }
+    }
+
+    LV2_Worker_Status respond (uint32_t size, const void* data) noexcept {
+        if (! responses.write (&size, sizeof (size), data, size)) {
+            response_overflows.fetch_add (1, std::memory_order_relaxed);
+            return LV2_WORKER_ERR_NO_SPACE;
+        }
+        return LV2_WORKER_SUCCESS;
+    }
+
+    static LV2_Worker_Status _schedule_work (LV2_Worker_Schedule_Handle self,
+                                             uint32_t size,
+                                             const void* data) {
+        return (static_cast<WorkerThread*> (self))->schedule_work (size, data);
+    }
+
+    static LV2_Worker_Status _respond (LV2_Worker_Respond_Handle self,
+                                       uint32_t size,
+                                       const void* data) {
+        return (static_cast<WorkerThread*> (self))->respond (size, data);
+    }
+};
+
+} // namespace lvtk
@@ -2,7 +2,7 @@
 #include <lvtk/plugin.hpp>
 #include <math.h>
 
-#define LVTK_VOLUME_URI "http://lvtk.org/plugins/volume"
+#include "volume.hpp"
 
 class Volume : public lvtk::Plugin<Volume> {
 public:
@@ -11,20 +11,14 @@ public:
     }
 
     void connect_port (uint32_t port, void* data) {
-        if (port == 0)
-            input[0] = (float*) data;
-        else if (port == 1)
-            input[1] = (float*) data;
-        else if (port == 2)
-            output[0] = (float*) data;
-        else if (port == 3)
-            output[1] = (float*) data;
-        else if (port == 4)
-            db = (float*) data;
+        ports.connect (port, data);
     }
 
     void run (uint32_t nframes) {
-        gains.next = *db > -90.0f ? powf (10.0f, *db * 0.05f) : 0.0f;
+        const float* input[2] = { ports.audio<0>(), ports.audio<1>() };
+        float* output[2] = { ports.audio<2>(), ports.audio<3>() };
+        const float db = ports.control<4>();
+        gains.next = db > -90.0f ? powf (10.0f, db * 0.05f) : 0.0f;
 
         if (fabsf (gains.last - gains.next) < 0.01) {
             // constant gain
@@ -52,9 +46,7 @@ public:
     }
 
 private:
-    float* input[2] { 0, 0 };
-    float* output[2] { 0, 0 };
-    float* db = nullptr;
+    lvtk::PortTable<volume_ports> ports;
     float lpf = 0.f;
 
     struct Gains {
@@ -0,0 +1,38 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+#pragma once
+
+#include <lv2/core/lv2.h>
+#include <lv2/units/units.h>
+#include <lvtk/metadata.hpp>
+
+#define LVTK_VOLUME_URI "http://lvtk.org/plugins/volume"
+
+static constexpr lvtk::ScalePoint volume_scale_points[] = {
+    { "+5", 5.f },
+    { "0", 0.f },
+    { "-5", -5.f },
+    { "-10", -10.f }
+};
+
+static constexpr lvtk::PortInfo volume_ports[] = {
+    lvtk::audio_input ("input_1", "In 1"),
+    lvtk::audio_input ("input_2", "In 2"),
+    lvtk::audio_output ("output_1", "Out 1"),
+    lvtk::audio_output ("output_2", "Out 2"),
+    lvtk::control_input ("volume", "Volume", -90.f, 24.f, 0.f)
+        .with_unit (LV2_UNITS__db)
+        .with_scale_points (volume_scale_points)
+};
+
+static constexpr const char* volume_features[] = {
+    LV2_CORE__hardRTCapable
+};
+
+static constexpr auto volume_info = lvtk::PluginInfo (LVTK_VOLUME_URI, "Volume", volume_ports)
+                                        .with_class (LV2_CORE__AmplifierPlugin)
+                                        .with_license ("https://opensource.org/licenses/ISC")
+                                        .with_project ("http://lvtk.org/plugins/")
+                                        .with_ui (LVTK_VOLUME_URI "/ui")
+                                        .with_optional_features (volume_features);
@@ -0,0 +1,15 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+// Writes volume.ttl from the declarations in volume.hpp
+
+#include <cstdio>
+#include "volume.hpp"
+
+int main (int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf (stderr, "usage: %s OUTPUT\n", argv[0]);
+        return 1;
+    }
+    return lvtk::write_turtle_file (argv[1], volume_info) ? 0 : 1;
+}
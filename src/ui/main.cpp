@@ -55,6 +55,7 @@ void Main::elevate (Widget& widget, uintptr_t parent) {
     view->realize();
     view->set_visible (widget.visible());
     widget._view = std::move (view);
+    widget.update_subscriptions();
 }
 
 }
@@ -58,7 +58,7 @@ void NanoVGSurface::translate (const Point<int>& pt) {
 }
 
 void NanoVGSurface::set_clip_bounds (const Rectangle<int>& r) {
-    auto rf = r.as<float>();
+    auto rf = r.as<float>() + ctx->state.origin;
     if (rf == ctx->state.clip)
         return;
     nvgScissor (ctx->ctx, rf.x, rf.y, rf.width, rf.height);
@@ -66,7 +66,7 @@ void NanoVGSurface::set_clip_bounds (const Rectangle<int>& r) {
 }
 
 Rectangle<int> NanoVGSurface::clip_bounds() const {
-    return ctx->state.clip.as<int>();
+    return (ctx->state.clip - ctx->state.origin).as<int>();
 }
 
 void NanoVGSurface::set_fill (const Fill& fill) {
@@ -85,6 +85,10 @@ void NanoVGSurface::begin_frame (int width, int height, float scale) {
     // are nvg pixel ratio and PuglView scale same?
     auto pixel_ratio = scale;
     nvgBeginFrame (ctx->ctx, width, height, pixel_ratio);
+    // nvgBeginFrame resets the scissor
+    ctx->stack.clear();
+    ctx->state.origin = {};
+    ctx->state.clip = { 0.f, 0.f, (float) width, (float) height };
 }
 
 void NanoVGSurface::end_frame() {
@@ -50,10 +50,12 @@ struct View::EventHandler {
     }
 
     static PuglStatus map (View& view, const PuglMapEvent& ev) {
+        view._widget.update_subscriptions();
         return PUGL_SUCCESS;
     }
 
     static PuglStatus unmap (View& view, const PuglUnmapEvent& ev) {
+        view._widget.update_subscriptions();
         return PUGL_SUCCESS;
     }
 
@@ -200,6 +202,14 @@ void View::set_backend (uintptr_t b) {
     puglSetBackend ((PuglView*) _view, (PuglBackend*) b);
 }
 
+void View::set_double_buffered (bool double_buffered) {
+    puglSetViewHint ((PuglView*) _view, PUGL_DOUBLE_BUFFER, double_buffered ? PUGL_TRUE : PUGL_FALSE);
+}
+
+bool View::double_buffered() const {
+    return puglGetViewHint ((PuglView*) _view, PUGL_DOUBLE_BUFFER) != PUGL_FALSE;
+}
+
 uintptr_t View::handle() { return puglGetNativeView ((PuglView*) _view); }
 double View::scale() const noexcept { return puglGetScaleFactor ((PuglView*) _view); }
 
@@ -230,9 +240,26 @@ void View::realize() {
     puglRealize ((PuglView*) _view);
 }
 
+void View::repaint (Bounds area) {
+    if (area.empty() || ! visible())
+        return;
+    PuglRect r;
+    r.x = area.x;
+    r.y = area.y;
+    r.width = area.width;
+    r.height = area.height;
+    puglPostRedisplayRect ((PuglView*) _view, r);
+}
+
 //==
 void View::render (Surface& ctx) {
+    const auto b = bounds();
+    render (ctx, { 0, 0, b.width, b.height });
+}
+
+void View::render (Surface& ctx, Bounds area) {
     Graphics g (ctx);
+    g.clip (area);
     _widget.render (g);
 }
 
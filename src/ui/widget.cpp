@@ -3,14 +3,175 @@
 #include "lvtk/ui/main.hpp"
 #include "lvtk/ui/style.hpp"
 #include <algorithm>
+#include <cmath>
+#include <unordered_map>
 
 namespace lvtk {
 namespace detail {
+
+/** Uniform grid of a container's children.
+
+    Each cell lists the children overlapping it ordered bottom to top, so a
+    hit test only looks at one cell.  Children are moved between cells
+    when their bounds change and the grid is rebuilt when the container
+    is resized or gets much more crowded than when it was built.
+ */
+class WidgetGrid final {
+public:
+    /** Lay out cells for the container and insert children in z-order */
+    void rebuild (const Widget& owner, const std::vector<Widget*>& children) {
+        width = std::max (0, owner.width());
+        height = std::max (0, owner.height());
+
+        const auto count = std::max<size_t> (1, children.size());
+        const auto side = std::sqrt ((double) width * (double) height / (double) count);
+        cell = std::max (min_cell, (int) side);
+        cols = std::min (max_cells, (width + cell - 1) / cell);
+        rows = std::min (max_cells, (height + cell - 1) / cell);
+        cell_w = cols > 0 ? (width + cols - 1) / cols : cell;
+        cell_h = rows > 0 ? (height + rows - 1) / rows : cell;
+
+        cells.clear();
+        cells.resize ((size_t) (cols * rows));
+        items.clear();
+        next_order = 0;
+        built_for = children.size();
+        for (auto child : children)
+            insert (child);
+    }
+
+    /** True if enough children were added since the last rebuild that the
+        cells are too coarse */
+    bool crowded() const noexcept { return items.size() > built_for * 2 + 16; }
+
+    /** Add a child on top of the others */
+    void insert (Widget* child) {
+        auto& item = items[child];
+        item.order = next_order++;
+        item.range = range (child->bounds());
+        each_cell (item.range, [&] (std::vector<Entry>& c) {
+            c.push_back ({ child, item.order });
+        });
+    }
+
+    /** Remove a child */
+    void erase (Widget* child) {
+        auto it = items.find (child);
+        if (it == items.end())
+            return;
+        unlink (child, it->second.range);
+        items.erase (it);
+    }
+
+    /** Move a child to the cells of its current bounds */
+    void update (Widget* child) {
+        auto it = items.find (child);
+        if (it == items.end())
+            return;
+
+        auto& item = it->second;
+        const auto r = range (child->bounds());
+        if (r == item.range)
+            return;
+
+        unlink (child, item.range);
+        item.range = r;
+        each_cell (r, [&] (std::vector<Entry>& c) {
+            const Entry e { child, item.order };
+            c.insert (std::upper_bound (c.begin(), c.end(), e, [] (const Entry& a, const Entry& b) {
+                          return a.order < b.order;
+                      }),
+                      e);
+        });
+    }
+
+    /** Call fn for children whose bounds contain pt, top-most first,
+        until it returns true.
+        @returns true if fn returned true
+     */
+    template <typename Fn>
+    bool visit (Point<int> pt, Fn&& fn) const {
+        if (pt.x < 0 || pt.y < 0 || pt.x >= width || pt.y >= height)
+            return false;
+        const int col = std::min (cols - 1, pt.x / cell_w);
+        const int row = std::min (rows - 1, pt.y / cell_h);
+        const auto& c = cells[(size_t) (row * cols + col)];
+        for (auto it = c.rbegin(); it != c.rend(); ++it)
+            if (it->widget->bounds().contains (pt) && fn (*it->widget))
+                return true;
+        return false;
+    }
+
+private:
+    static constexpr int min_cell = 16;
+    static constexpr int max_cells = 256;
+
+    struct Entry {
+        Widget* widget;
+        uint64_t order;
+    };
+
+    /** Inclusive range of cells, empty if col1 > col2 */
+    struct Range {
+        int col1 = 0, row1 = 0, col2 = -1, row2 = -1;
+        bool operator== (const Range& o) const noexcept {
+            return col1 == o.col1 && row1 == o.row1 && col2 == o.col2 && row2 == o.row2;
+        }
+    };
+
+    struct Item {
+        uint64_t order;
+        Range range;
+    };
+
+    int width = 0, height = 0;
+    int cell = min_cell, cell_w = min_cell, cell_h = min_cell;
+    int cols = 0, rows = 0;
+    std::vector<std::vector<Entry>> cells;
+    std::unordered_map<Widget*, Item> items;
+    uint64_t next_order = 0;
+    size_t built_for = 0;
+
+    Range range (Bounds b) const noexcept {
+        b = b.intersection ({ 0, 0, width, height });
+        if (b.empty() || cols <= 0 || rows <= 0)
+            return {};
+        return {
+            b.x / cell_w,
+            b.y / cell_h,
+            std::min (cols - 1, (b.x + b.width - 1) / cell_w),
+            std::min (rows - 1, (b.y + b.height - 1) / cell_h)
+        };
+    }
+
+    template <typename Fn>
+    void each_cell (const Range& r, Fn&& fn) {
+        for (int row = r.row1; row <= r.row2; ++row)
+            for (int col = r.col1; col <= r.col2; ++col)
+                fn (cells[(size_t) (row * cols + col)]);
+    }
+
+    void unlink (Widget* child, const Range& r) {
+        each_cell (r, [child] (std::vector<Entry>& c) {
+            c.erase (std::remove_if (c.begin(), c.end(), [child] (const Entry& e) {
+                         return e.widget == child;
+                     }),
+                     c.end());
+        });
+    }
+};
+
 template <typename T>
 static int round_int (T v) { return static_cast<int> (v); }
 
+/** Pixel containing pos. Floors so that negative fractions land left of
+    zero and the grid and the widgets agree on the pixel. */
+static Point<int> pixel (Point<float> pos) {
+    return { round_int (std::floor (pos.x)), round_int (std::floor (pos.y)) };
+}
+
 static bool test_pos (Widget& widget, Point<float> pos) {
-    auto ipos = pos.as<int>();
+    auto ipos = pixel (pos);
     return widget.bounds().at (0, 0).contains (ipos)
            && widget.obstructed (ipos.x, ipos.y);
 }
@@ -73,27 +234,139 @@ static Point<float> convert_coord (const Widget* tgt, Widget* src, Point<float>
 
 } // namespace detail
 
+//=============================================================================
+Widget::Widget() {
+    _weak_status.reset (this);
+}
+
+Widget::~Widget() {
+    // don't leave the parent or children pointing here
+    if (_parent != nullptr)
+        _parent->remove (this);
+    for (auto child : _widgets) {
+        child->_parent = nullptr;
+        child->update_subscriptions();
+    }
+
+    if (_subscriptions != nullptr)
+        for (const auto& p : _ports)
+            _subscriptions->release (p.port, p.protocol);
+    _weak_status.reset (nullptr);
+}
+
 //=============================================================================
 bool Widget::visible() const noexcept { return _visible; }
 
 void Widget::set_visible (bool v) {
     if (_visible != v) {
+        if (! v)
+            repaint();
         _visible = v;
         if (_view)
             _view->set_visible (visible());
+        else if (v)
+            repaint();
+        update_subscriptions();
+    }
+}
+
+bool Widget::showing() const noexcept {
+    for (auto it = this; it != nullptr; it = it->_parent) {
+        if (! it->_visible)
+            return false;
+        if (it->_view != nullptr)
+            return it->_view->visible();
+    }
+    return false;
+}
+
+//=============================================================================
+void Widget::watch_port (uint32_t port, uint32_t protocol) {
+    for (const auto& p : _ports)
+        if (p.port == port && p.protocol == protocol)
+            return;
+    _ports.push_back ({ port, protocol });
+    if (_subscriptions != nullptr)
+        _subscriptions->retain (port, protocol);
+}
+
+void Widget::unwatch_port (uint32_t port, uint32_t protocol) {
+    auto it = std::find_if (_ports.begin(), _ports.end(), [&] (const WatchedPort& p) {
+        return p.port == port && p.protocol == protocol;
+    });
+    if (it == _ports.end())
+        return;
+    _ports.erase (it);
+    if (_subscriptions != nullptr)
+        _subscriptions->release (port, protocol);
+}
+
+void Widget::update_subscriptions() {
+    PortSubscriptions* subs = nullptr;
+    if (showing())
+        if (auto view = find_view())
+            subs = view->_main.port_subscriptions();
+
+    if (subs != _subscriptions) {
+        for (const auto& p : _ports) {
+            if (subs != nullptr)
+                subs->retain (p.port, p.protocol);
+            if (_subscriptions != nullptr)
+                _subscriptions->release (p.port, p.protocol);
+        }
+        _subscriptions = subs;
+    }
+
+    for (auto child : _widgets)
+        child->update_subscriptions();
+}
+
+//=============================================================================
+void Widget::repaint() {
+    repaint (_bounds.at (0, 0));
+}
+
+void Widget::repaint (Bounds area) {
+    for (auto it = this; it != nullptr; it = it->_parent) {
+        if (! it->_visible)
+            return;
+
+        if (it->_view != nullptr) {
+            area = area.intersection (it->_bounds.at (0, 0));
+            if (! area.empty())
+                it->_view->repaint (area);
+            return;
+        }
+
+        area = area.intersection (it->_bounds.at (0, 0));
+        if (area.empty())
+            return;
+        area += it->_bounds.pos();
     }
 }
 
 //=============================================================================
 void Widget::set_bounds (int x, int y, int width, int height) {
     const bool was_moved = _bounds.x != x || _bounds.y != y;
-    const bool was_resized = _bounds.width != width || _bounds.width != y;
+    const bool was_resized = _bounds.width != width || _bounds.height != height;
+    if (! (was_moved || was_resized))
+        return;
+
+    // damage where this was and where it will be
+    if (_parent != nullptr && _view == nullptr && _visible)
+        _parent->repaint (_bounds.united ({ x, y, width, height }));
+
     _bounds.x = x;
     _bounds.y = y;
     _bounds.width = width;
     _bounds.height = height;
-    if (was_moved || was_resized)
-        resized();
+
+    if (_parent != nullptr && _parent->_index != nullptr)
+        _parent->_index->update (this);
+    if (was_resized && _index != nullptr)
+        _index->rebuild (*this, _widgets);
+
+    resized();
 }
 
 void Widget::set_bounds (Bounds b) { set_bounds (b.x, b.y, b.width, b.height); }
@@ -106,25 +379,57 @@ void Widget::set_size (int width, int height) {
 void Widget::add (Widget& widget) {
     _widgets.push_back (&widget);
     widget._parent = this;
+    if (_index != nullptr) {
+        if (_index->crowded())
+            _index->rebuild (*this, _widgets);
+        else
+            _index->insert (&widget);
+    }
+    widget.update_subscriptions();
+    widget.repaint();
     resized();
 }
 
 void Widget::remove (Widget* widget) {
     auto it = std::find (_widgets.begin(), _widgets.end(), widget);
-    if (it != _widgets.end())
+    if (it != _widgets.end()) {
+        widget->repaint();
         _widgets.erase (it);
+        if (_index != nullptr)
+            _index->erase (widget);
+        widget->_parent = nullptr;
+        widget->update_subscriptions();
+    }
 }
 
 void Widget::remove (Widget& widget) {
     remove (&widget);
 }
 
+void Widget::set_spatial_index (bool enabled) {
+    if (enabled == spatial_index())
+        return;
+    if (! enabled) {
+        _index.reset();
+        return;
+    }
+    _index = std::make_unique<detail::WidgetGrid>();
+    _index->rebuild (*this, _widgets);
+}
+
 bool Widget::obstructed (int x, int y) {
     auto pos = Point<int>{x, y}.as<float>();
+    auto test = [&pos] (Widget& child) {
+        return child.visible() && detail::test_pos (child, detail::coord_from_parent_space (child, pos));
+    };
+
+    // the grid only covers this widget, children may stick out of it
+    if (_index != nullptr && contains (x, y))
+        return _index->visit ({ x, y }, test);
+
     for (auto child : _widgets) {
-        if (child->visible() && detail::test_pos (*child, detail::coord_from_parent_space (*child, pos))) {
+        if (test (*child))
             return true;
-        }
     }
 
     return false;
@@ -132,11 +437,20 @@ bool Widget::obstructed (int x, int y) {
 
 Widget* Widget::widget_at (Point<float> pos) {
     if (_visible && detail::test_pos (*this, pos)) {
-        for (auto child : _widgets) {
-            if (auto c2 = child->widget_at (detail::coord_from_parent_space (*child, pos)))
-                return c2;
+        Widget* found = nullptr;
+        auto test = [&pos, &found] (Widget& child) {
+            found = child.widget_at (detail::coord_from_parent_space (child, pos));
+            return found != nullptr;
+        };
+
+        if (_index != nullptr) {
+            _index->visit (detail::pixel (pos), test);
+        } else {
+            for (auto it = _widgets.rbegin(); it != _widgets.rend() && ! test (**it); ++it)
+                ;
         }
-        return this;
+
+        return found != nullptr ? found : this;
     }
     return nullptr;
 }
@@ -170,13 +484,15 @@ void Widget::render (Graphics& g) {
 }
 
 void Widget::render_internal (Graphics& g) {
+    const auto clip = g.clip_bounds();
     paint (g);
 
     for (auto cw : _widgets) {
-        if (! cw->visible())
+        if (! cw->visible() || ! clip.intersects (cw->bounds()))
             continue;
         g.save();
         g.translate (cw->bounds().pos());
+        g.clip (cw->bounds().at (0, 0));
         cw->render (g);
         g.restore();
     }
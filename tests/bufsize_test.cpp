@@ -5,9 +5,20 @@ struct BufSizePlug : lvtk::Plugin<BufSizePlug, lvtk::BufSize> {
     BufSizePlug (const lvtk::Args& args) : Plugin (args) {}
 };
 
+struct ReconfigurePlug : lvtk::Plugin<ReconfigurePlug, lvtk::BufSize, lvtk::Options> {
+    ReconfigurePlug (const lvtk::Args& args) : Plugin (args) {}
+    void reconfigure() {
+        ++reconfigured;
+        max = buffer_details().max.value_or (0);
+    }
+    int reconfigured = 0;
+    uint32_t max = 0;
+};
+
 class BufSize : public TestFixutre {
     CPPUNIT_TEST_SUITE (BufSize);
     CPPUNIT_TEST (buffer_details);
+    CPPUNIT_TEST (reconfigure);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -59,6 +70,57 @@ protected:
         CPPUNIT_ASSERT (details.nominal != pdetails.nominal);
     }
 
+    void reconfigure() {
+        auto plugin = std::unique_ptr<ReconfigurePlug> (new ReconfigurePlug (args));
+        CPPUNIT_ASSERT (! plugin->options_sample_rate());
+
+        uint32_t max = 512;
+        float rate = 96000.f;
+        lvtk::OptionArray changes;
+        changes.add (LV2_OPTIONS_INSTANCE, 0, urid.map (LV2_BUF_SIZE__maxBlockLength), sizeof (uint32_t), type, &max)
+            .add (LV2_OPTIONS_INSTANCE, 0, urid.map (LV2_PARAMETERS__sampleRate), sizeof (float), urid.map (LV2_ATOM__Float), &rate);
+
+        lvtk::Descriptor<ReconfigurePlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+        auto iface = (const LV2_Options_Interface*) desc.extension_data (LV2_OPTIONS__interface);
+        CPPUNIT_ASSERT (iface != nullptr);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) LV2_OPTIONS_SUCCESS, iface->set (plugin.get(), changes.get()));
+        lvtk::descriptors().pop_back();
+
+        CPPUNIT_ASSERT_EQUAL (1, plugin->reconfigured);
+        CPPUNIT_ASSERT_EQUAL (max, plugin->max);
+        CPPUNIT_ASSERT_EQUAL (max, *plugin->buffer_details().max);
+        CPPUNIT_ASSERT_EQUAL (*details.min, *plugin->buffer_details().min);
+        CPPUNIT_ASSERT_EQUAL (96000.0, *plugin->options_sample_rate());
+
+        // same values again don't reconfigure
+        plugin->set (changes.get());
+        CPPUNIT_ASSERT_EQUAL (1, plugin->reconfigured);
+
+        // integer rates are converted, not read as floating point
+        const auto rate_key = urid.map (LV2_PARAMETERS__sampleRate);
+        int32_t int_rate = 48000;
+        lvtk::OptionArray ints;
+        ints.add (LV2_OPTIONS_INSTANCE, 0, rate_key, sizeof (int32_t), urid.map (LV2_ATOM__Int), &int_rate);
+        plugin->set (ints.get());
+        CPPUNIT_ASSERT_EQUAL (2, plugin->reconfigured);
+        CPPUNIT_ASSERT_EQUAL (48000.0, *plugin->options_sample_rate());
+
+        int64_t long_rate = 44100;
+        lvtk::OptionArray longs;
+        longs.add (LV2_OPTIONS_INSTANCE, 0, rate_key, sizeof (int64_t), urid.map (LV2_ATOM__Long), &long_rate);
+        plugin->set (longs.get());
+        CPPUNIT_ASSERT_EQUAL (3, plugin->reconfigured);
+        CPPUNIT_ASSERT_EQUAL (44100.0, *plugin->options_sample_rate());
+
+        // unknown types are ignored
+        lvtk::OptionArray other;
+        other.add (LV2_OPTIONS_INSTANCE, 0, rate_key, sizeof (int32_t), type, &int_rate);
+        plugin->set (other.get());
+        CPPUNIT_ASSERT_EQUAL (3, plugin->reconfigured);
+        CPPUNIT_ASSERT_EQUAL (44100.0, *plugin->options_sample_rate());
+    }
+
 private:
     lvtk::Args args;
     LV2_Feature options_feature = { LV2_OPTIONS__options, nullptr };
@@ -0,0 +1,152 @@
+#include <thread>
+
+#include "tests.hpp"
+
+struct Meter {
+    uint32_t count;
+    float peak;
+};
+
+// same size as Meter
+struct Pair {
+    float left, right;
+};
+
+struct ChannelPlug : lvtk::Plugin<ChannelPlug, lvtk::Channels> {
+    ChannelPlug (const lvtk::Args& args) : Plugin (args) {
+        add_channel (LVTK_TEST_PLUGIN_URI "#meter", meter);
+    }
+
+    lvtk::SharedChannel<Meter> meter;
+};
+
+struct ChannelUI : lvtk::UI<ChannelUI, lvtk::ChannelAccess> {
+    ChannelUI (const lvtk::UIArgs& args) : UI (args) {}
+};
+
+class Channel : public TestFixutre {
+    CPPUNIT_TEST_SUITE (Channel);
+    CPPUNIT_TEST (triple_buffer);
+    CPPUNIT_TEST (threaded);
+    CPPUNIT_TEST (shared);
+    CPPUNIT_TEST (atom_fallback);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void triple_buffer() {
+        lvtk::TripleBuffer<Meter> buffer;
+        Meter m;
+        CPPUNIT_ASSERT (! buffer.read (m));
+        buffer.write ({ 1, 0.5f });
+        buffer.write ({ 2, 0.25f });
+        CPPUNIT_ASSERT (buffer.read (m));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, m.count);
+        CPPUNIT_ASSERT (! buffer.update());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, buffer.read_buffer().count);
+
+        // the writer never gets the buffer being read
+        buffer.write_buffer().count = 3;
+        buffer.publish();
+        CPPUNIT_ASSERT (buffer.update());
+        buffer.write_buffer().count = 4;
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 3, buffer.read_buffer().count);
+    }
+
+    void threaded() {
+        lvtk::TripleBuffer<Meter> buffer;
+        const uint32_t total = 200000;
+        std::thread producer ([&] {
+            for (uint32_t i = 1; i <= total; ++i) {
+                auto& m = buffer.write_buffer();
+                m.count = i;
+                m.peak = (float) i;
+                buffer.publish();
+            }
+        });
+
+        uint32_t last = 0;
+        while (last < total) {
+            Meter m;
+            if (! buffer.read (m))
+                continue;
+            CPPUNIT_ASSERT (m.count > last);
+            CPPUNIT_ASSERT_EQUAL ((float) m.count, m.peak);
+            last = m.count;
+        }
+        producer.join();
+    }
+
+    void shared() {
+        lvtk::Descriptor<ChannelPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+        const LV2_Feature* const features[] = { nullptr };
+        auto instance = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<ChannelPlug*> (instance);
+
+        LV2_Extension_Data_Feature data_data = { desc.extension_data };
+        const LV2_Feature inst_feature = { LV2_INSTANCE_ACCESS_URI, instance };
+        const LV2_Feature data_feature = { LV2_DATA_ACCESS_URI, &data_data };
+        lvtk::UIArgs args;
+        args.features.push_back (inst_feature);
+        args.features.push_back (data_feature);
+        std::unique_ptr<ChannelUI> ui (new ChannelUI (args));
+
+        CPPUNIT_ASSERT (ui->find_channel<Meter> (LVTK_TEST_PLUGIN_URI "#other") == nullptr);
+        CPPUNIT_ASSERT (ui->find_channel<float> (LVTK_TEST_PLUGIN_URI "#meter") == nullptr);
+        CPPUNIT_ASSERT (ui->find_channel<Pair> (LVTK_TEST_PLUGIN_URI "#meter") == nullptr);
+        CPPUNIT_ASSERT (! plugin->meter.attached());
+
+        lvtk::ChannelReader<Meter> reader;
+        reader.set_channel (ui->find_channel<Meter> (LVTK_TEST_PLUGIN_URI "#meter"));
+        CPPUNIT_ASSERT (reader.shared());
+        CPPUNIT_ASSERT (plugin->meter.attached());
+
+        plugin->meter.write ({ 7, 0.7f });
+        Meter m;
+        CPPUNIT_ASSERT (reader.read (m));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 7, m.count);
+        CPPUNIT_ASSERT (! reader.read (m));
+
+        // one reader at a time, others fall back to atoms
+        std::unique_ptr<ChannelUI> other (new ChannelUI (args));
+        CPPUNIT_ASSERT (other->find_channel<Meter> (LVTK_TEST_PLUGIN_URI "#meter") == nullptr);
+        CPPUNIT_ASSERT (ui->find_channel<Meter> (LVTK_TEST_PLUGIN_URI "#meter") == nullptr);
+
+        ui.reset();
+        CPPUNIT_ASSERT (! plugin->meter.attached());
+        CPPUNIT_ASSERT (other->find_channel<Meter> (LVTK_TEST_PLUGIN_URI "#meter") == &plugin->meter);
+        other.reset();
+        CPPUNIT_ASSERT (! plugin->meter.attached());
+        desc.cleanup (instance);
+        lvtk::descriptors().pop_back();
+    }
+
+    void atom_fallback() {
+        // no instance or data access
+        lvtk::UIArgs args;
+        ChannelUI ui (args);
+        lvtk::ChannelReader<Meter> reader;
+        reader.set_channel (ui.find_channel<Meter> (LVTK_TEST_PLUGIN_URI "#meter"));
+        CPPUNIT_ASSERT (! reader.shared());
+
+        struct {
+            LV2_Atom atom;
+            Meter body;
+        } event = { { sizeof (Meter), 1 }, { 9, 0.9f } };
+        Meter m;
+        CPPUNIT_ASSERT (! reader.read (m));
+        reader.receive (event.atom);
+        CPPUNIT_ASSERT (reader.read (m));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 9, m.count);
+        CPPUNIT_ASSERT (! reader.read (m));
+
+        event.atom.size = 3;
+        reader.receive (event.atom);
+        CPPUNIT_ASSERT (! reader.read (m));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (Channel);
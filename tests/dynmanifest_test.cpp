@@ -2,6 +2,8 @@
 #include "tests.hpp"
 #include <lvtk/dynmanifest.hpp>
 
+#include "../lvtk.lv2/volume.hpp"
+
 class TestManifest : public lvtk::DynManifest {
 public:
     bool get_subjects (std::stringstream& lines) override {
@@ -17,6 +19,24 @@ public:
     }
 };
 
+class StreamManifest : public lvtk::DynManifest {
+public:
+    bool write_subjects (lvtk::ManifestWriter& out) override {
+        out << "@prefix lv2:   <http://lv2plug.in/ns/lv2core#> .\n";
+        for (int i = 0; i < 2000; ++i)
+            out << "<http://myplugin.org/" << i << "> a lv2:Plugin .\n";
+        return true;
+    }
+
+    bool write_data (lvtk::ManifestWriter& out, const std::string& uri) override {
+        ++renders;
+        out << "<" << uri << "> lv2:port [ lv2:default " << 0.5 << " ; lv2:index " << 3u << " ] ." << std::endl;
+        return true;
+    }
+
+    int renders = 0;
+};
+
 void* lvtk_create_dyn_manifest() {
     return new TestManifest();
 }
@@ -25,6 +45,8 @@ class DynManifest : public TestFixutre {
     CPPUNIT_TEST_SUITE (DynManifest);
     CPPUNIT_TEST (subjects);
     CPPUNIT_TEST (get_data);
+    CPPUNIT_TEST (streaming);
+    CPPUNIT_TEST (plugin_manifest);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -65,8 +87,72 @@ protected:
         }
     }
 
+    void streaming() {
+        StreamManifest stream;
+        LV2_Dyn_Manifest_Handle handle = &stream;
+        FILE* file = tmpfile();
+        CPPUNIT_ASSERT (file != nullptr);
+
+        CPPUNIT_ASSERT_EQUAL (0, lv2_dyn_manifest_get_subjects (handle, file));
+        std::string expected;
+        {
+            lvtk::ManifestWriter out (expected);
+            stream.write_subjects (out);
+        }
+        CPPUNIT_ASSERT (expected.size() > LVTK_MANIFEST_BUFFER_SIZE);
+        CPPUNIT_ASSERT_EQUAL (expected, read_all (file));
+
+        // data is rendered once per uri
+        fclose (file);
+        file = tmpfile();
+        for (int i = 0; i < 3; ++i)
+            CPPUNIT_ASSERT_EQUAL (0, lv2_dyn_manifest_get_data (handle, file, "http://myplugin.org/1"));
+        CPPUNIT_ASSERT_EQUAL (1, stream.renders);
+        const std::string line ("<http://myplugin.org/1> lv2:port [ lv2:default 0.5 ; lv2:index 3 ] .\n");
+        CPPUNIT_ASSERT_EQUAL (line + line + line, read_all (file));
+
+        stream.set_data_cached (false);
+        CPPUNIT_ASSERT_EQUAL (0, lv2_dyn_manifest_get_data (handle, file, "http://myplugin.org/1"));
+        CPPUNIT_ASSERT_EQUAL (2, stream.renders);
+
+        // the stringstream api still works through the C callbacks
+        std::unique_ptr<TestManifest> legacy ((TestManifest*) lvtk_create_dyn_manifest());
+        rewind (file);
+        CPPUNIT_ASSERT_EQUAL (0, lv2_dyn_manifest_get_data (legacy.get(), file, "http://myplugin.org"));
+        fclose (file);
+    }
+
+    void plugin_manifest() {
+        lvtk::PluginManifest plugins;
+        plugins.add (volume_info);
+        LV2_Dyn_Manifest_Handle handle = &plugins;
+
+        FILE* file = tmpfile();
+        CPPUNIT_ASSERT_EQUAL (0, lv2_dyn_manifest_get_subjects (handle, file));
+        CPPUNIT_ASSERT (read_all (file).find ("<" LVTK_VOLUME_URI "> a lv2:Plugin .") != std::string::npos);
+        fclose (file);
+
+        // same turtle as the build step writes
+        file = tmpfile();
+        CPPUNIT_ASSERT_EQUAL (0, lv2_dyn_manifest_get_data (handle, file, LVTK_VOLUME_URI));
+        std::ostringstream expected;
+        lvtk::write_turtle (expected, volume_info);
+        CPPUNIT_ASSERT_EQUAL (expected.str(), read_all (file));
+        CPPUNIT_ASSERT (0 != lv2_dyn_manifest_get_data (handle, file, "http://myplugin.org"));
+        fclose (file);
+    }
+
 private:
     std::unique_ptr<TestManifest> manifest;
+
+    static std::string read_all (FILE* file) {
+        fflush (file);
+        const long size = ftell (file);
+        std::string text ((size_t) size, '\0');
+        rewind (file);
+        CPPUNIT_ASSERT_EQUAL ((size_t) size, fread (&text[0], 1, (size_t) size, file));
+        return text;
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (DynManifest);
@@ -6,11 +6,15 @@ struct LogPlug : lvtk::Plugin<LogPlug, lvtk::Log> {
     void trace (const std::string& message) {
         log << message;
     }
+    lvtk::Logger& logger() { return log; }
 };
 
 class LogTest : public TestFixutre {
     CPPUNIT_TEST_SUITE (LogTest);
     CPPUNIT_TEST (integration);
+    CPPUNIT_TEST (deferred);
+    CPPUNIT_TEST (typed);
+    CPPUNIT_TEST (long_strings);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -48,10 +52,153 @@ protected:
         lvtk::descriptors().pop_back(); // needed so descriptor count test doesn't fail
     }
 
+    void deferred() {
+        lvtk::URIDirectory uris;
+        LV2_Log_Log host = { this, _printf, _vprintf };
+        const LV2_Feature flog = { LV2_LOG__log, &host };
+        lvtk::Args args;
+        args.features.push_back (*uris.get_map_feature());
+        args.features.push_back (flog);
+
+        LogPlug plugin (args);
+        auto& log = plugin.logger();
+        const auto trace = uris.map (LV2_LOG__Trace);
+        log.set_deferred (true, 256);
+        CPPUNIT_ASSERT (log.deferred());
+
+        messages.clear();
+        types.clear();
+        std::string text ("copied");
+        log.printf (trace, "%d %5.2f %s %c %lu%% %*d|%-4s|%llx\n",
+                    -42, 3.14159, text.c_str(), 'x', 7ul, 4, 9, "ab", 255ull);
+        text = "changed";
+        log << "100% literal";
+        CPPUNIT_ASSERT (messages.empty());
+
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, log.flush());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, messages.size());
+        CPPUNIT_ASSERT_EQUAL (std::string ("-42  3.14 copied x 7%    9|ab  |ff\n"), messages[0]);
+        CPPUNIT_ASSERT_EQUAL (std::string ("100% literal"), messages[1]);
+        CPPUNIT_ASSERT_EQUAL (trace, types[0]);
+
+        // overflow the queue
+        messages.clear();
+        types.clear();
+        for (int i = 0; i < 100; ++i)
+            log.printf (trace, "message %d\n", i);
+        CPPUNIT_ASSERT (log.dropped() > 0);
+        const auto flushed = log.flush();
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 100, flushed + log.dropped());
+        CPPUNIT_ASSERT_EQUAL (std::string ("message 0\n"), messages[1]);
+        CPPUNIT_ASSERT (messages[0].find ("dropped") != std::string::npos);
+        CPPUNIT_ASSERT_EQUAL (uris.map (LV2_LOG__Warning), types[0]);
+
+        log.set_deferred (false);
+        messages.clear();
+        types.clear();
+        log.printf (trace, "direct %d", 1);
+        CPPUNIT_ASSERT_EQUAL (std::string ("direct 1"), messages.at (0));
+    }
+
+    void long_strings() {
+        // strings near the record size are truncated, never left untagged
+        for (size_t n = 120; n < LVTK_LOG_MAX_RECORD + 8; ++n) {
+            const std::string text (n, 'x');
+            lvtk::detail::LogRecord record;
+            CPPUNIT_ASSERT (record.put_string (text.c_str()));
+            CPPUNIT_ASSERT (record.size <= LVTK_LOG_MAX_RECORD);
+            const auto out = lvtk::format_log ("%s", record.data, record.size);
+            CPPUNIT_ASSERT (out.size() > 0 && out.size() <= n);
+            CPPUNIT_ASSERT (text.compare (0, out.size(), out) == 0);
+        }
+
+        // after other arguments fill most of the record
+        for (uint32_t count = 100; count < 124; ++count) {
+            lvtk::detail::LogRecord record;
+            std::string format;
+            for (uint32_t i = 0; i < count; ++i) {
+                CPPUNIT_ASSERT (record.put_uint (0));
+                format += "%u";
+            }
+            format += "%s";
+            CPPUNIT_ASSERT (record.put_string ("yyyy"));
+            const auto out = lvtk::format_log (format.c_str(), record.data, record.size);
+            CPPUNIT_ASSERT_EQUAL (std::string (count, '0') + "yyyy", out);
+        }
+    }
+
+    void typed() {
+        using lvtk::detail::check_log_format;
+        static_assert (check_log_format<> ("plain 100%%"), "");
+        static_assert (check_log_format<int, double, const char*> ("%d %.2f %s"), "");
+        static_assert (check_log_format<int, unsigned> ("%*u"), "");
+        static_assert (! check_log_format<int> ("%s"), "");
+        static_assert (! check_log_format<double> ("%d"), "");
+        static_assert (! check_log_format<int> ("%d %d"), "");
+        static_assert (! check_log_format<int, int> ("%d"), "");
+        static_assert (! check_log_format<int*> ("%n"), "");
+
+        static constexpr lvtk::LogFormat<uint32_t, float, const char*> xrun ("xrun at %u load %.1f in %s\n");
+        static constexpr lvtk::LogFormat<> done ("done\n");
+        static_assert (xrun.id == lvtk::detail::log_format_id ("xrun at %u load %.1f in %s\n"), "");
+
+        lvtk::Symbols symbols;
+        auto map = (LV2_URID_Map*) symbols.get_map_feature()->data;
+        auto unmap = (const LV2_URID_Unmap*) symbols.get_unmap_feature()->data;
+        LV2_Log_Log host = { this, _printf, _vprintf };
+        lvtk::Logger log;
+        log.set (LV2_Feature { LV2_LOG__log, &host });
+        log.init (map);
+        const auto trace = symbols.map (LV2_LOG__Trace);
+        const auto error = symbols.map (LV2_LOG__Error);
+
+        messages.clear();
+        types.clear();
+        CPPUNIT_ASSERT (log.write (trace, xrun, 128, 0.5, "run"));
+        CPPUNIT_ASSERT_EQUAL (std::string ("xrun at 128 load 0.5 in run\n"), messages.at (0));
+
+        // deferred records go to a binary sink unformatted
+        log.set_deferred (true);
+        for (uint32_t i = 0; i < 10; ++i)
+            log.write (trace, xrun, i, i * 0.5f, "run");
+        log.write (error, done);
+        lvtk::BinaryLog sink (unmap);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 11, log.flush (sink));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, messages.size());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 11, sink.records());
+
+        std::vector<std::string> texts;
+        std::vector<std::string> uris;
+        CPPUNIT_ASSERT (lvtk::BinaryLog::read (sink.data(), sink.size(), [&] (const lvtk::BinaryLog::Entry& e) {
+            texts.push_back (e.text());
+            uris.push_back (e.type_uri);
+        }));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 11, texts.size());
+        CPPUNIT_ASSERT_EQUAL (std::string ("xrun at 3 load 1.5 in run\n"), texts[3]);
+        CPPUNIT_ASSERT_EQUAL (std::string ("done\n"), texts[10]);
+        CPPUNIT_ASSERT_EQUAL (std::string (LV2_LOG__Trace), uris[0]);
+        CPPUNIT_ASSERT_EQUAL (std::string (LV2_LOG__Error), uris[10]);
+
+        // formats are stored once
+        size_t text_size = 0;
+        for (const auto& t : texts)
+            text_size += t.size();
+        CPPUNIT_ASSERT (sink.size() < text_size + 2 * std::strlen (LV2_LOG__Trace));
+
+        // truncated logs stop at the damage
+        texts.clear();
+        CPPUNIT_ASSERT (! lvtk::BinaryLog::read (sink.data(), sink.size() - 1, [&] (const lvtk::BinaryLog::Entry& e) {
+            texts.push_back (e.text());
+        }));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 10, texts.size());
+    }
+
 private:
     enum { buffer_size = 256 };
     char buffer [buffer_size];
     LV2_URID msg_type = 0;
+    std::vector<std::string> messages;
+    std::vector<LV2_URID> types;
 
 	static int _printf (LV2_Log_Handle, LV2_URID, const char*, ...) { return 0; }
 
@@ -59,7 +206,10 @@ private:
         auto& buffer = static_cast<LogTest*>(handle)->buffer;
         static_cast<LogTest*>(handle)->msg_type = type;
         memset (buffer, 0, buffer_size);
-        return vsprintf (buffer, msg, args);
+        const int res = vsnprintf (buffer, buffer_size, msg, args);
+        static_cast<LogTest*>(handle)->messages.push_back (buffer);
+        static_cast<LogTest*>(handle)->types.push_back (type);
+        return res;
     }
 };
 
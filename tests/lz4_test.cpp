@@ -0,0 +1,85 @@
+
+#include <random>
+#include <vector>
+
+#include "tests.hpp"
+
+class LZ4Test : public TestFixutre {
+    CPPUNIT_TEST_SUITE (LZ4Test);
+    CPPUNIT_TEST (round_trip);
+    CPPUNIT_TEST (ratio);
+    CPPUNIT_TEST (corrupt);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    static std::vector<uint8_t> pack (const std::vector<uint8_t>& in) {
+        std::vector<uint8_t> out (lvtk::lz4::compress_bound (in.size()));
+        out.resize (lvtk::lz4::compress (in.data(), in.size(), out.data(), out.size()));
+        return out;
+    }
+
+    static bool check (const std::vector<uint8_t>& in) {
+        const auto packed = pack (in);
+        if (packed.empty())
+            return false;
+        std::vector<uint8_t> out (in.size());
+        const auto size = lvtk::lz4::decompress (packed.data(), packed.size(), out.data(), out.size());
+        return size == in.size() && out == in;
+    }
+
+    void round_trip() {
+        std::mt19937 rng (1234);
+        std::vector<uint8_t> data;
+
+        CPPUNIT_ASSERT (check (data));
+        data = { 1, 2, 3 };
+        CPPUNIT_ASSERT (check (data));
+
+        // incompressible
+        data.resize (10000);
+        for (auto& b : data)
+            b = (uint8_t) rng();
+        CPPUNIT_ASSERT (check (data));
+
+        // one long run, overlapping matches and long lengths
+        data.assign (100000, 7);
+        CPPUNIT_ASSERT (check (data));
+
+        // repeating pattern with noise
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = (uint8_t) ((i % 300) ^ (rng() % 17 == 0 ? rng() : 0));
+        CPPUNIT_ASSERT (check (data));
+    }
+
+    void ratio() {
+        std::vector<float> table (4096);
+        for (size_t i = 0; i < table.size(); ++i)
+            table[i] = (float) (i % 64) / 64.f;
+        std::vector<uint8_t> data ((uint8_t*) table.data(), (uint8_t*) (table.data() + table.size()));
+        CPPUNIT_ASSERT (pack (data).size() < data.size() / 10);
+        CPPUNIT_ASSERT (check (data));
+    }
+
+    void corrupt() {
+        std::vector<uint8_t> data (5000);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = (uint8_t) (i % 50);
+        auto packed = pack (data);
+        std::vector<uint8_t> out (data.size());
+
+        // too small an output
+        CPPUNIT_ASSERT_EQUAL ((size_t) 0, lvtk::lz4::decompress (packed.data(), packed.size(), out.data(), out.size() - 1));
+        // truncated input
+        CPPUNIT_ASSERT (data.size() != lvtk::lz4::decompress (packed.data(), packed.size() / 2, out.data(), out.size()));
+        // bad offset
+        uint8_t bad[] = { 0x10, 'a', 0x05, 0x00 };
+        CPPUNIT_ASSERT_EQUAL ((size_t) 0, lvtk::lz4::decompress (bad, sizeof (bad), out.data(), out.size()));
+        // too small a destination for compress
+        CPPUNIT_ASSERT_EQUAL ((size_t) 0, lvtk::lz4::compress (data.data(), data.size(), out.data(), 10));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (LZ4Test);
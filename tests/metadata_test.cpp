@@ -0,0 +1,120 @@
+
+#include <cmath>
+#include <fstream>
+#include <unistd.h>
+
+#include "tests.hpp"
+#include "../lvtk.lv2/volume.hpp"
+
+static constexpr lvtk::PortInfo metadata_ports[] = {
+    lvtk::atom_input ("control", "Control"),
+    lvtk::control_input ("gain", "Gain \"dB\"", -12.f, 12.f, 0.f),
+    lvtk::control_output ("level", "Level", 0.f, 1.f),
+    lvtk::cv_output ("cv", "CV")
+};
+
+static constexpr auto metadata_info = lvtk::PluginInfo (LVTK_TEST_PLUGIN_URI, "Test", metadata_ports)
+                                          .with_version (2, 4);
+
+static_assert (metadata_info.num_ports == 4, "");
+static_assert (metadata_info.port_index ("level") == 2, "");
+static_assert (metadata_info.port_index ("lev") == 4, "");
+static_assert (volume_info.port_index ("volume") == 4, "");
+static_assert (metadata_ports[1].clamp (20.f) == 12.f, "");
+
+class Metadata : public TestFixutre {
+    CPPUNIT_TEST_SUITE (Metadata);
+    CPPUNIT_TEST (port_table);
+    CPPUNIT_TEST (turtle);
+    CPPUNIT_TEST (finite_ranges);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void port_table() {
+        lvtk::PortTable<metadata_ports> ports;
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 4, ports.size);
+        CPPUNIT_ASSERT (! ports.connected());
+
+        float gain = 0.f, level = 0.f, cv[4] = {};
+        uint8_t atom[64] = {};
+        ports.connect (0, atom);
+        ports.connect (1, &gain);
+        ports.connect (2, &level);
+        ports.connect (3, cv);
+        ports.connect (4, &gain); // ignored
+        CPPUNIT_ASSERT (ports.connected());
+        CPPUNIT_ASSERT (ports.data<0>() == atom);
+        CPPUNIT_ASSERT (ports.audio<3>() == cv);
+
+        gain = 6.f;
+        CPPUNIT_ASSERT_EQUAL (6.f, ports.control<1>());
+        gain = 100.f;
+        CPPUNIT_ASSERT_EQUAL (12.f, ports.control<1>());
+        gain = -100.f;
+        CPPUNIT_ASSERT_EQUAL (-12.f, ports.control<1>());
+        gain = NAN;
+        CPPUNIT_ASSERT_EQUAL (0.f, ports.control<1>());
+
+        ports.set_control<2> (2.f);
+        CPPUNIT_ASSERT_EQUAL (1.f, level);
+        ports.set_control<2> (0.5f);
+        CPPUNIT_ASSERT_EQUAL (0.5f, level);
+    }
+
+    void turtle() {
+        std::ostringstream ttl;
+        lvtk::write_turtle (ttl, metadata_info);
+        const auto text = ttl.str();
+        auto has = [&text] (const char* str) { return text.find (str) != std::string::npos; };
+        CPPUNIT_ASSERT (has ("<" LVTK_TEST_PLUGIN_URI ">\n\ta lv2:Plugin ;"));
+        CPPUNIT_ASSERT (has ("lv2:minorVersion 2 ;\n\tlv2:microVersion 4"));
+        CPPUNIT_ASSERT (has ("a atom:AtomPort , lv2:InputPort ;\n\t\tatom:bufferType atom:Sequence"));
+        CPPUNIT_ASSERT (has ("lv2:name \"Gain \\\"dB\\\"\""));
+        CPPUNIT_ASSERT (has ("lv2:minimum -12.0 ;\n\t\tlv2:maximum 12.0 ;\n\t\tlv2:default 0.0"));
+        CPPUNIT_ASSERT (has ("lv2:index 3 ;\n\t\tlv2:symbol \"cv\""));
+        CPPUNIT_ASSERT (! has ("lv2:index 4"));
+
+        ttl.str ("");
+        lvtk::write_turtle (ttl, volume_info);
+        const auto volume = ttl.str();
+        CPPUNIT_ASSERT (volume.find ("a lv2:Plugin , lv2:AmplifierPlugin ;") != std::string::npos);
+        CPPUNIT_ASSERT (volume.find ("lv2:optionalFeature lv2:hardRTCapable") != std::string::npos);
+        CPPUNIT_ASSERT (volume.find ("units:unit units:db") != std::string::npos);
+        CPPUNIT_ASSERT (volume.find ("rdfs:label \"-10\" ;\n\t\t\trdf:value -10.0") != std::string::npos);
+
+        char path[] = "/tmp/lvtk_metadata_XXXXXX";
+        const int fd = mkstemp (path);
+        CPPUNIT_ASSERT (fd >= 0);
+        close (fd);
+        CPPUNIT_ASSERT (lvtk::write_turtle_file (path, volume_info));
+        std::ifstream file (path);
+        std::stringstream written;
+        written << file.rdbuf();
+        CPPUNIT_ASSERT_EQUAL (volume, written.str());
+        unlink (path);
+    }
+
+    void finite_ranges() {
+        // constexpr ports with these ranges don't compile
+        static_assert (lvtk::detail::is_finite (-90.f), "");
+        static_assert (! lvtk::detail::is_finite (INFINITY), "");
+        static_assert (! lvtk::detail::is_finite (NAN), "");
+
+        auto rejected = [] (float min, float max, float def) {
+            try {
+                lvtk::control_input ("x", "X", min, max, def);
+            } catch (const std::invalid_argument&) {
+                return true;
+            }
+            return false;
+        };
+        CPPUNIT_ASSERT (! rejected (-90.f, 24.f, 0.f));
+        CPPUNIT_ASSERT (rejected (-INFINITY, 24.f, 0.f));
+        CPPUNIT_ASSERT (rejected (0.f, 1.f, NAN));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (Metadata);
@@ -4,6 +4,8 @@
 class Options : public TestFixutre {
     CPPUNIT_TEST_SUITE (Options);
     CPPUNIT_TEST (array);
+    CPPUNIT_TEST (growth);
+    CPPUNIT_TEST (copy_and_move);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -48,6 +50,73 @@ protected:
         for (const auto& opt : opts_ref) // check values are same
             CPPUNIT_ASSERT_EQUAL (1024, (int) *(uint32_t*) opt.value);
     }
+
+    void growth() {
+        const auto key = urids.map (LV2_BUF_SIZE__maxBlockLength);
+        const auto type = urids.map (LV2_ATOM__Int);
+
+        lvtk::OptionArray opts;
+        for (int32_t i = 0; i < 100; ++i)
+            opts.add (key, type, i);
+        opts.add (key, urids.map (LV2_ATOM__Double), 0.5);
+
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 101, opts.size());
+        check_values (opts);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, opts.get()[101].key);
+        CPPUNIT_ASSERT (opts.get()[101].value == nullptr);
+
+        // reuse keeps working after clear
+        opts.clear();
+        CPPUNIT_ASSERT (opts.empty());
+        opts.reserve (200);
+        opts.add (LV2_OPTIONS_INSTANCE, 0, key, type, (int32_t) 7);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, opts.size());
+        CPPUNIT_ASSERT_EQUAL (7, *(const int32_t*) opts.get()[0].value);
+    }
+
+    void copy_and_move() {
+        const auto key = urids.map (LV2_BUF_SIZE__maxBlockLength);
+        const auto type = urids.map (LV2_ATOM__Int);
+
+        for (int32_t total : { 4, 40 }) {
+            lvtk::OptionArray a;
+            for (int32_t i = 0; i < total; ++i)
+                a.add (key, type, i);
+
+            lvtk::OptionArray b = a;
+            a.clear();
+            for (int32_t i = 0; i < total; ++i)
+                a.add (key, type, -1);
+            CPPUNIT_ASSERT_EQUAL ((uint32_t) total, b.size());
+            check_values (b);
+
+            lvtk::OptionArray c = std::move (b);
+            CPPUNIT_ASSERT (b.empty());
+            CPPUNIT_ASSERT_EQUAL ((uint32_t) total, c.size());
+            check_values (c);
+
+            b = c;
+            check_values (b);
+            CPPUNIT_ASSERT (b.get()[0].value != c.get()[0].value);
+        }
+
+        // referenced arrays copy as references
+        lvtk::OptionArray owner;
+        owner.add (key, type, (int32_t) 0);
+        lvtk::OptionArray ref (owner.get());
+        lvtk::OptionArray copy = ref;
+        CPPUNIT_ASSERT (copy.get() == owner.get());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, copy.size());
+    }
+
+private:
+    static void check_values (const lvtk::OptionArray& opts) {
+        int32_t i = 0;
+        for (const auto& opt : opts) {
+            if (opt.size == sizeof (int32_t))
+                CPPUNIT_ASSERT_EQUAL (i++, *(const int32_t*) opt.value);
+        }
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (Options);
@@ -0,0 +1,67 @@
+
+#include "tests.hpp"
+
+class RingBufferTest : public TestFixutre {
+    CPPUNIT_TEST_SUITE (RingBufferTest);
+    CPPUNIT_TEST (capacity);
+    CPPUNIT_TEST (read_write);
+    CPPUNIT_TEST (wrap_around);
+    CPPUNIT_TEST (overflow);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void capacity() {
+        lvtk::RingBuffer ring (100);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 128, ring.size());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 127, ring.write_space());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, ring.read_space());
+    }
+
+    void read_write() {
+        lvtk::RingBuffer ring (64);
+        const uint32_t size = 4, value = 1234;
+        CPPUNIT_ASSERT (ring.write (&size, sizeof (size), &value, sizeof (value)));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 8, ring.read_space());
+
+        uint32_t out = 0;
+        CPPUNIT_ASSERT (ring.peek (&out, sizeof (out)));
+        CPPUNIT_ASSERT_EQUAL (size, out);
+        CPPUNIT_ASSERT (ring.skip (sizeof (out)));
+        CPPUNIT_ASSERT (ring.read (&out, sizeof (out)));
+        CPPUNIT_ASSERT_EQUAL (value, out);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, ring.read_space());
+        CPPUNIT_ASSERT (! ring.read (&out, sizeof (out)));
+    }
+
+    void wrap_around() {
+        lvtk::RingBuffer ring (16);
+        char in[10], out[10];
+        for (int i = 0; i < 10; ++i) {
+            for (int j = 0; j < 10; ++j)
+                in[j] = (char) (i + j);
+            CPPUNIT_ASSERT (ring.write (in, sizeof (in)));
+            CPPUNIT_ASSERT (ring.read (out, sizeof (out)));
+            CPPUNIT_ASSERT (memcmp (in, out, sizeof (in)) == 0);
+        }
+    }
+
+    void overflow() {
+        lvtk::RingBuffer ring (16);
+        char data[16] = { 0 };
+        CPPUNIT_ASSERT (! ring.write (data, 16));
+        CPPUNIT_ASSERT (ring.write (data, 15));
+        CPPUNIT_ASSERT (! ring.write (data, 1));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 15, ring.read_space());
+
+        // parts whose sizes wrap when added are still too big
+        lvtk::RingBuffer empty (16);
+        CPPUNIT_ASSERT (! empty.write (data, 8, data, UINT32_MAX - 3));
+        CPPUNIT_ASSERT (! empty.write (data, UINT32_MAX, data, 2));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, empty.read_space());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (RingBufferTest);
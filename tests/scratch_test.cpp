@@ -0,0 +1,114 @@
+#include "tests.hpp"
+
+struct ScratchPlug : lvtk::Plugin<ScratchPlug, lvtk::Scratch> {
+    ScratchPlug (const lvtk::Args& args) : Plugin (args) {}
+};
+
+class Scratch : public TestFixutre {
+    CPPUNIT_TEST_SUITE (Scratch);
+    CPPUNIT_TEST (block_length);
+    CPPUNIT_TEST (borrowing);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        subject = urid.map ("http://dummy.subject.org");
+        type = urid.map ("http://www.w3.org/2001/XMLSchema#nonNegativeInteger");
+        args.sample_rate = 44100.0;
+        args.bundle = "/fake/bundle.lv2";
+    }
+
+protected:
+    void block_length() {
+        uint32_t nominal = 256, max = 1024;
+        {
+            // no options, uses the fallback
+            ScratchPlug plugin (args);
+            CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_FALLBACK_BLOCK_LENGTH, plugin.scratch_block_length());
+        }
+
+        options.add (LV2_OPTIONS_BLANK, subject, urid.map (LV2_BUF_SIZE__nominalBlockLength), sizeof (uint32_t), type, &nominal);
+        add_features();
+        {
+            ScratchPlug plugin (args);
+            CPPUNIT_ASSERT_EQUAL (nominal, plugin.scratch_block_length());
+        }
+
+        options.add (LV2_OPTIONS_BLANK, subject, urid.map (LV2_BUF_SIZE__maxBlockLength), sizeof (uint32_t), type, &max);
+        options_feature.data = const_cast<lvtk::Option*> (options.get());
+        args.features.front() = options_feature;
+        {
+            ScratchPlug plugin (args);
+            CPPUNIT_ASSERT_EQUAL (max, plugin.scratch_block_length());
+            CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_BUFFERS, plugin.scratch_available());
+        }
+    }
+
+    void borrowing() {
+        ScratchPlug plugin (args);
+        const uint32_t nframes = plugin.scratch_block_length();
+        {
+            auto a = plugin.scratch (nframes);
+            auto b = plugin.scratch<double> (nframes);
+            CPPUNIT_ASSERT (a && b);
+            CPPUNIT_ASSERT_EQUAL (nframes, a.size());
+            CPPUNIT_ASSERT_EQUAL ((uintptr_t) 0, (uintptr_t) a.data() % LVTK_SCRATCH_ALIGNMENT);
+            CPPUNIT_ASSERT_EQUAL ((uintptr_t) 0, (uintptr_t) b.data() % LVTK_SCRATCH_ALIGNMENT);
+            CPPUNIT_ASSERT ((void*) a.data() != (void*) b.data());
+
+            // buffers don't overlap
+            b.clear();
+            for (auto& s : a)
+                s = 1.f;
+            for (auto s : b)
+                CPPUNIT_ASSERT_EQUAL (0.0, s);
+
+            CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_BUFFERS - 2, plugin.scratch_available());
+            CPPUNIT_ASSERT (! plugin.scratch (nframes + 1));
+        }
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_BUFFERS, plugin.scratch_available());
+
+        // run out, then give back
+        std::vector<lvtk::ScratchBuffer<float>> held;
+        for (int i = 0; i < LVTK_SCRATCH_BUFFERS; ++i)
+            held.push_back (plugin.scratch (nframes));
+        CPPUNIT_ASSERT (! plugin.scratch (1));
+        held.pop_back();
+        CPPUNIT_ASSERT ((bool) plugin.scratch (1));
+        held.clear();
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_BUFFERS, plugin.scratch_available());
+
+        // returning out of order doesn't free buffers still borrowed
+        lvtk::ScratchBuffer<float> outer;
+        {
+            auto first = plugin.scratch (nframes);
+            outer = plugin.scratch (nframes);
+        }
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_BUFFERS - 1, plugin.scratch_available());
+        auto next = plugin.scratch (nframes);
+        CPPUNIT_ASSERT (next.data() != outer.data());
+        next.release();
+        outer.release();
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) LVTK_SCRATCH_BUFFERS, plugin.scratch_available());
+
+        plugin.resize_scratch (2, 64);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, plugin.scratch_available());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 64, plugin.scratch_block_length());
+    }
+
+private:
+    void add_features() {
+        options_feature.data = const_cast<lvtk::Option*> (options.get());
+        args.features.push_back (options_feature);
+        args.features.push_back (*urid.get_map_feature());
+    }
+
+    lvtk::Args args;
+    LV2_Feature options_feature = { LV2_OPTIONS__options, nullptr };
+    lvtk::OptionArray options;
+    lvtk::URIDirectory urid;
+    uint32_t subject;
+    uint32_t type;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (Scratch);
@@ -0,0 +1,161 @@
+
+#include <unistd.h>
+
+#include "tests.hpp"
+
+class StateArchiveTest : public TestFixutre {
+    CPPUNIT_TEST_SUITE (StateArchiveTest);
+    CPPUNIT_TEST (store_retrieve);
+    CPPUNIT_TEST (many_keys);
+    CPPUNIT_TEST (snapshot);
+    CPPUNIT_TEST (serialize);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void store_retrieve() {
+        lvtk::StateArchive archive;
+        CPPUNIT_ASSERT (archive.empty());
+        CPPUNIT_ASSERT (archive.retrieve (1) == nullptr);
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_ERR_UNKNOWN, archive.store (0, "x", 1, 1, 0));
+
+        float gain = 0.5f;
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, archive.store (10, &gain, sizeof (gain), 20, LV2_STATE_IS_POD));
+        size_t size = 0;
+        uint32_t type = 0, flags = 0;
+        auto data = archive.retrieve (10, &size, &type, &flags);
+        CPPUNIT_ASSERT (data != nullptr);
+        CPPUNIT_ASSERT_EQUAL (sizeof (float), size);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 20, type);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) LV2_STATE_IS_POD, flags);
+        CPPUNIT_ASSERT_EQUAL (0.5f, *(const float*) data);
+
+        // smaller values reuse the record, larger ones move
+        archive.store (10, "ab", 3, 21, 0);
+        CPPUNIT_ASSERT_EQUAL (std::string ("ab"), std::string ((const char*) archive.retrieve (10)));
+        std::vector<uint8_t> big (1000, 7);
+        archive.store (10, big.data(), big.size(), 22, 0);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, archive.size());
+        CPPUNIT_ASSERT (0 == memcmp (big.data(), archive.retrieve (10, &size), big.size()));
+        CPPUNIT_ASSERT_EQUAL (big.size(), size);
+
+        // removed keys can be stored again
+        CPPUNIT_ASSERT (archive.remove (10));
+        CPPUNIT_ASSERT (! archive.remove (10));
+        CPPUNIT_ASSERT (! archive.contains (10));
+        archive.store (10, &gain, sizeof (gain), 20, 0);
+        CPPUNIT_ASSERT (archive.contains (10));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, archive.size());
+
+        // sizes which don't fit 32 bits are refused, not truncated
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_ERR_NO_SPACE, archive.store (11, &gain, UINT32_MAX, 20, 0));
+        if (sizeof (size_t) > sizeof (uint32_t)) {
+            const auto huge = (size_t) UINT32_MAX + 5;
+            CPPUNIT_ASSERT_EQUAL (LV2_STATE_ERR_NO_SPACE, archive.store (11, &gain, huge, 20, 0));
+            CPPUNIT_ASSERT_EQUAL (LV2_STATE_ERR_NO_SPACE, archive.store (10, &gain, huge, 20, 0));
+        }
+        CPPUNIT_ASSERT (! archive.contains (11));
+        CPPUNIT_ASSERT_EQUAL (0.5f, *(const float*) archive.retrieve (10, &size));
+        CPPUNIT_ASSERT_EQUAL (sizeof (float), size);
+    }
+
+    void many_keys() {
+        lvtk::StateArchive archive;
+        for (uint32_t key = 1; key <= 1000; ++key)
+            archive.store (key, &key, sizeof (key), 1, 0);
+        for (uint32_t key = 1; key <= 1000; key += 2)
+            archive.remove (key);
+        for (uint32_t key = 1; key <= 1000; ++key) {
+            std::vector<uint32_t> v (key % 7 + 1, key);
+            if (key % 3 == 0)
+                archive.store (key, v.data(), v.size() * sizeof (uint32_t), 2, 0);
+        }
+
+        CPPUNIT_ASSERT (archive.bytes() > 0);
+        size_t count = 0;
+        archive.for_each ([&] (uint32_t key, const void* data, size_t size, uint32_t type, uint32_t) {
+            CPPUNIT_ASSERT_EQUAL (key, *(const uint32_t*) data);
+            ++count;
+        });
+        CPPUNIT_ASSERT_EQUAL (archive.size(), count);
+
+        for (uint32_t key = 1; key <= 1000; ++key) {
+            const bool expected = key % 2 == 0 || key % 3 == 0;
+            CPPUNIT_ASSERT_EQUAL (expected, archive.contains (key));
+        }
+    }
+
+    void snapshot() {
+        lvtk::StateArchive a;
+        int32_t value = 1;
+        a.store (5, &value, sizeof (value), 1, 0);
+
+        lvtk::StateArchive b = a;
+        value = 2;
+        b.store (5, &value, sizeof (value), 1, 0);
+        CPPUNIT_ASSERT_EQUAL (1, *(const int32_t*) a.retrieve (5));
+        CPPUNIT_ASSERT_EQUAL (2, *(const int32_t*) b.retrieve (5));
+
+        // StateStore / StateRetrieve wrappers
+        auto store = a.get_store();
+        value = 3;
+        store (6, &value, sizeof (value), 1);
+        auto retrieve = a.get_retrieve();
+        CPPUNIT_ASSERT_EQUAL (3, *(const int32_t*) retrieve (6));
+
+        b.merge (a);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, b.size());
+        CPPUNIT_ASSERT_EQUAL (1, *(const int32_t*) b.retrieve (5));
+    }
+
+    void serialize() {
+        lvtk::Symbols symbols;
+        auto map = (const LV2_URID_Map*) symbols.get_map_feature()->data;
+        auto unmap = (const LV2_URID_Unmap*) symbols.get_unmap_feature()->data;
+
+        lvtk::StateArchive a;
+        const double ratio = 1.5;
+        std::vector<float> table (512, 0.25f);
+        a.store (symbols.map (LVTK_TEST_PLUGIN_URI "#ratio"), &ratio, sizeof (ratio),
+                 symbols.map (LV2_ATOM__Double), LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE);
+        a.store (symbols.map (LVTK_TEST_PLUGIN_URI "#table"), table.data(), table.size() * sizeof (float),
+                 symbols.map (LV2_ATOM__Chunk), LV2_STATE_IS_POD);
+
+        const auto bytes = a.serialize (*unmap);
+        CPPUNIT_ASSERT (! bytes.empty());
+
+        // another host maps URIs differently
+        lvtk::Symbols other;
+        other.map ("urn:something:else");
+        auto other_map = (const LV2_URID_Map*) other.get_map_feature()->data;
+        lvtk::StateArchive b;
+        CPPUNIT_ASSERT (b.deserialize (bytes.data(), bytes.size(), *other_map));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, b.size());
+        uint32_t type = 0;
+        auto data = b.retrieve (other.map (LVTK_TEST_PLUGIN_URI "#ratio"), nullptr, &type);
+        CPPUNIT_ASSERT (data != nullptr);
+        CPPUNIT_ASSERT_EQUAL (1.5, *(const double*) data);
+        CPPUNIT_ASSERT_EQUAL (other.map (LV2_ATOM__Double), type);
+
+        // truncated data is rejected and leaves the archive alone
+        CPPUNIT_ASSERT (! b.deserialize (bytes.data(), bytes.size() - 1, *other_map));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, b.size());
+
+        char path[] = "/tmp/lvtk_archive_XXXXXX";
+        const int fd = mkstemp (path);
+        CPPUNIT_ASSERT (fd >= 0);
+        close (fd);
+        CPPUNIT_ASSERT (a.write_file (path, *unmap));
+        lvtk::StateArchive c;
+        CPPUNIT_ASSERT (c.read_file (path, *map));
+        size_t size = 0;
+        data = c.retrieve (symbols.map (LVTK_TEST_PLUGIN_URI "#table"), &size);
+        CPPUNIT_ASSERT_EQUAL (table.size() * sizeof (float), size);
+        CPPUNIT_ASSERT (0 == memcmp (table.data(), data, size));
+        unlink (path);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (StateArchiveTest);
@@ -0,0 +1,76 @@
+// Copyright 2022 Michael Fisher <mfisher@kushview.net>
+// SPDX-License-Identifier: ISC
+
+// Compares saving and restoring a large state value stored raw and compressed.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <lvtk/ext/state.hpp>
+#include <lvtk/plugin.hpp>
+#include <lvtk/state_archive.hpp>
+#include <lvtk/symbols.hpp>
+
+#define BENCH_PLUGIN_URI "http://lvtk.org/plugins/state_benchmark"
+
+struct BenchPlug : lvtk::Plugin<BenchPlug, lvtk::State> {
+    BenchPlug (const lvtk::Args& args) : Plugin (args) {
+        add_state_blob (BENCH_PLUGIN_URI "#wavetables", LV2_ATOM__Chunk, &BenchPlug::wavetables);
+    }
+
+    void compress (size_t threshold) { set_state_compression (threshold); }
+
+    std::vector<float> wavetables;
+};
+
+static lvtk::Descriptor<BenchPlug> bench_plugin (BENCH_PLUGIN_URI);
+
+static void run (const char* name, size_t threshold) {
+    const auto& desc = lvtk::descriptors().front();
+    lvtk::Symbols symbols;
+    const LV2_Feature* features[] = { symbols.get_map_feature(), symbols.get_unmap_feature(), nullptr };
+    const LV2_Feature* none[] = { nullptr };
+    auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+
+    auto handle = desc.instantiate (&desc, 48000.0, "/fake/path", features);
+    auto plugin = static_cast<BenchPlug*> (handle);
+    plugin->compress (threshold);
+
+    // 256 single cycle tables of 2048 samples, like a wavetable synth
+    plugin->wavetables.resize (256 * 2048);
+    for (size_t t = 0; t < 256; ++t)
+        for (size_t i = 0; i < 2048; ++i)
+            plugin->wavetables[t * 2048 + i] = (float) (int) ((i % 256) * (t + 1) % 256) / 128.f - 1.f;
+
+    const int iterations = 50;
+    lvtk::StateArchive values;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        values.clear();
+        iface->save (handle, lvtk::StateArchive::store_function, &values, 0, none);
+    }
+    const std::chrono::duration<double> saving = std::chrono::steady_clock::now() - start;
+    const size_t stored = values.bytes();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        iface->restore (handle, lvtk::StateArchive::retrieve_function, &values, 0, none);
+    const std::chrono::duration<double> loading = std::chrono::steady_clock::now() - start;
+
+    const double raw_mb = plugin->wavetables.size() * sizeof (float) / (1024.0 * 1024.0);
+    std::printf ("%-12s stored %6.2f MB  save %7.3f ms  restore %7.3f ms  %8.1f MB/s\n",
+                 name,
+                 stored / (1024.0 * 1024.0),
+                 1000.0 * saving.count() / iterations,
+                 1000.0 * loading.count() / iterations,
+                 raw_mb * iterations / loading.count());
+
+    desc.cleanup (handle);
+}
+
+int main() {
+    run ("raw", 0);
+    run ("compressed", 4096);
+    return 0;
+}
@@ -0,0 +1,188 @@
+
+#include <atomic>
+#include <thread>
+
+#include "tests.hpp"
+
+// plugin with properties which tracks changes
+struct CachedPlug : lvtk::Plugin<CachedPlug, lvtk::State> {
+    CachedPlug (const lvtk::Args& args) : Plugin (args) {
+        gain_key = add_state_property (LVTK_TEST_PLUGIN_URI "#gain", &CachedPlug::gain);
+        mix_key = add_state_property (LVTK_TEST_PLUGIN_URI "#mix", &CachedPlug::mix);
+        add_state_property (LVTK_TEST_PLUGIN_URI "#mode", &CachedPlug::mode);
+    }
+
+    uint32_t gain_key = 0, mix_key = 0;
+    float gain = 1.f;
+    float mix = 0.5f;
+    int32_t mode = 0;
+
+    void set_gain (float value) {
+        gain = value;
+        state_changed (gain_key);
+    }
+
+    float late = 0.75f;
+    uint32_t add_late() { return add_state_property (LVTK_TEST_PLUGIN_URI "#late", &CachedPlug::late); }
+};
+
+// plugin with many properties, the one which changes registered last so
+// marking it takes long enough for saves to land in the middle
+struct WidePlug : lvtk::Plugin<WidePlug, lvtk::State> {
+    WidePlug (const lvtk::Args& args) : Plugin (args) {
+        for (int i = 0; i < 5000; ++i)
+            add_state_property (LVTK_TEST_PLUGIN_URI "#p" + std::to_string (i), &WidePlug::unused);
+        last_key = add_state_accessor<float> (
+            LVTK_TEST_PLUGIN_URI "#last",
+            [] (const WidePlug& self) { return self.last.load(); },
+            [] (WidePlug& self, const float& value) { self.last.store (value); });
+    }
+
+    uint32_t last_key = 0;
+    float unused = 0.f;
+    std::atomic<float> last { 0.f };
+
+    void set_last (float value) {
+        last.store (value);
+        state_changed (last_key);
+    }
+};
+
+// plugin with a hand written save
+struct FullPlug : lvtk::Plugin<FullPlug, lvtk::State> {
+    FullPlug (const lvtk::Args& args) : Plugin (args) {}
+
+    uint32_t value = 1;
+    lvtk::StateStatus save (lvtk::StateStore& store, uint32_t flags, const lvtk::FeatureList& features) {
+        return store (value, &value, sizeof (value), 1);
+    }
+};
+
+class StateCacheTest : public TestFixutre {
+    CPPUNIT_TEST_SUITE (StateCacheTest);
+    CPPUNIT_TEST (incremental);
+    CPPUNIT_TEST (full);
+    CPPUNIT_TEST (concurrent);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void incremental() {
+        lvtk::Descriptor<CachedPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::Symbols symbols;
+        const LV2_Feature* features[] = { symbols.get_map_feature(), nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<CachedPlug*> (handle);
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+
+        lvtk::StateCache cache;
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, cache.save (iface, handle, 0, nullptr));
+        CPPUNIT_ASSERT (cache.changed());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 3, cache.size());
+        const auto first = cache.generation();
+        CPPUNIT_ASSERT (first > 0);
+
+        // nothing changed
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, cache.save (iface, handle, 0, nullptr));
+        CPPUNIT_ASSERT (! cache.changed());
+        CPPUNIT_ASSERT_EQUAL (first, cache.generation());
+
+        // one key changed, the rest stay cached
+        plugin->set_gain (0.25f);
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, cache.save (iface, handle, 0, nullptr));
+        CPPUNIT_ASSERT (cache.changed());
+        CPPUNIT_ASSERT (cache.generation() > first);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 3, cache.size());
+        CPPUNIT_ASSERT_EQUAL (0.25f, *(const float*) cache.get (plugin->gain_key));
+        CPPUNIT_ASSERT_EQUAL (0.5f, *(const float*) cache.get (plugin->mix_key));
+
+        // properties registered after a save are new to the cache
+        const auto late_key = plugin->add_late();
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, cache.save (iface, handle, 0, nullptr));
+        CPPUNIT_ASSERT (cache.changed());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 4, cache.size());
+        CPPUNIT_ASSERT (cache.get (late_key) != nullptr);
+        CPPUNIT_ASSERT_EQUAL (0.75f, *(const float*) cache.get (late_key));
+
+        // cache restores a second instance
+        auto h2 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, cache.restore (iface, h2, 0, nullptr));
+        CPPUNIT_ASSERT_EQUAL (0.25f, static_cast<CachedPlug*> (h2)->gain);
+
+        desc.cleanup (handle);
+        desc.cleanup (h2);
+        lvtk::descriptors().pop_back();
+    }
+
+    void full() {
+        lvtk::Descriptor<FullPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+        const LV2_Feature* features[] = { nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<FullPlug*> (handle);
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+
+        lvtk::StateCache cache;
+        cache.save (iface, handle, 0, features);
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, cache.generation());
+        CPPUNIT_ASSERT (cache.get (1) != nullptr);
+
+        // full saves replace the cache
+        plugin->value = 2;
+        cache.save (iface, handle, 0, features);
+        CPPUNIT_ASSERT (cache.changed());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, cache.size());
+        CPPUNIT_ASSERT (cache.get (1) == nullptr);
+        CPPUNIT_ASSERT (cache.get (2) != nullptr);
+
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+
+    void concurrent() {
+        lvtk::Descriptor<WidePlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::Symbols symbols;
+        const LV2_Feature* features[] = { symbols.get_map_feature(), nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<WidePlug*> (handle);
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+
+        // saves run while a value changes, some landing mid change.  A
+        // save which starts after a change finished must include it.
+        const int total = 1000;
+        std::atomic<int> done { 0 }, checked { 0 };
+        std::thread changes ([&]() {
+            for (int i = 1; i <= total; ++i) {
+                plugin->set_last ((float) i);
+                done.store (i);
+                while (checked.load() < i)
+                    std::this_thread::yield();
+            }
+        });
+
+        lvtk::StateCache cache;
+        int lost = 0;
+        while (checked.load() < total) {
+            const int d = done.load();
+            cache.save (iface, handle, 0, nullptr);
+            if (d > checked.load()) {
+                if (*(const float*) cache.get (plugin->last_key) < (float) d)
+                    ++lost;
+                checked.store (d);
+            }
+        }
+        changes.join();
+        CPPUNIT_ASSERT_EQUAL (0, lost);
+
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (StateCacheTest);
@@ -1,4 +1,7 @@
 
+#include <thread>
+#include <unistd.h>
+
 #include "tests.hpp"
 
 struct StatePlug : lvtk::Plugin<StatePlug, lvtk::State> {
@@ -23,9 +26,109 @@ struct StatePlug : lvtk::Plugin<StatePlug, lvtk::State> {
     }
 };
 
+// plugin using registered state properties
+struct PropertyPlug : lvtk::Plugin<PropertyPlug, lvtk::State> {
+    PropertyPlug (const lvtk::Args& args) : Plugin (args) {
+        add_state_property (LVTK_TEST_PLUGIN_URI "#gain", &PropertyPlug::gain);
+        add_state_property (LVTK_TEST_PLUGIN_URI "#count", &PropertyPlug::count);
+        add_state_property (LVTK_TEST_PLUGIN_URI "#bypass", &PropertyPlug::bypass);
+        add_state_property (LVTK_TEST_PLUGIN_URI "#name", &PropertyPlug::name);
+        add_state_accessor<double> (
+            LVTK_TEST_PLUGIN_URI "#ratio",
+            [] (const PropertyPlug& self) { return self.ratio * 2.0; },
+            [] (PropertyPlug& self, const double& value) { self.ratio = value / 2.0; });
+        add_state_blob (LVTK_TEST_PLUGIN_URI "#table", LV2_ATOM__Chunk, &PropertyPlug::table);
+    }
+
+    float gain = 1.f;
+    int64_t count = 0;
+    bool bypass = false;
+    std::string name;
+    double ratio = 0.0;
+    std::vector<float> table;
+};
+
+// plugin storing a large value in a file
+struct FilePlug : lvtk::Plugin<FilePlug, lvtk::URID, lvtk::State> {
+    FilePlug (const lvtk::Args& args) : Plugin (args) {
+        key = map (LVTK_TEST_PLUGIN_URI "#capture");
+    }
+
+    uint32_t key = 0;
+    std::vector<float> capture;
+    lvtk::MappedFile restored;
+
+    lvtk::StateStatus save (lvtk::StateStore& store, uint32_t flags,
+                            const lvtk::FeatureList& features) {
+        return save_file (store, features, key, "capture.raw",
+                          capture.data(), capture.size() * sizeof (float));
+    }
+
+    lvtk::StateStatus restore (lvtk::StateRetrieve& retrieve, uint32_t flags,
+                               const lvtk::FeatureList& features) {
+        restored = restore_file (retrieve, features, key);
+        return restored ? LV2_STATE_SUCCESS : LV2_STATE_ERR_NO_PROPERTY;
+    }
+};
+
+struct Params {
+    explicit Params (float g) : gain (g), table (256, g) {}
+    float gain;
+    std::vector<float> table;
+};
+
+// plugin restored while running
+struct ExchangePlug : lvtk::Plugin<ExchangePlug, lvtk::URID, lvtk::State> {
+    ExchangePlug (const lvtk::Args& args) : Plugin (args), params (new Params (1.f)) {
+        key = map (LVTK_TEST_PLUGIN_URI "#gain");
+    }
+
+    uint32_t key = 0;
+    lvtk::StateExchange<Params> params;
+    std::atomic<int> applied { 0 };
+    float last = 0.f;
+
+    void run (uint32_t) {
+        if (params.apply())
+            ++applied;
+        const auto& p = *params.get();
+        // the table never disagrees with the gain it was built from
+        for (auto v : p.table)
+            if (v != p.gain)
+                last = -1.f;
+        if (last >= 0.f)
+            last = p.gain;
+    }
+
+    lvtk::StateStatus restore (lvtk::StateRetrieve& retrieve, uint32_t flags,
+                               const lvtk::FeatureList& features) {
+        if (auto gain = (const float*) retrieve (key)) {
+            params.post (new Params (*gain));
+            return LV2_STATE_SUCCESS;
+        }
+        return LV2_STATE_ERR_NO_PROPERTY;
+    }
+};
+
+// plugin storing compressed values
+struct CompressPlug : lvtk::Plugin<CompressPlug, lvtk::State> {
+    CompressPlug (const lvtk::Args& args) : Plugin (args) {
+        add_state_property (LVTK_TEST_PLUGIN_URI "#gain", &CompressPlug::gain);
+        add_state_blob (LVTK_TEST_PLUGIN_URI "#wavetable", LV2_ATOM__Chunk, &CompressPlug::wavetable);
+        set_state_compression (1024);
+    }
+
+    float gain = 1.f;
+    std::vector<float> wavetable;
+};
+
 class StateTest : public TestFixutre {
     CPPUNIT_TEST_SUITE (StateTest);
     CPPUNIT_TEST (integration);
+    CPPUNIT_TEST (properties);
+    CPPUNIT_TEST (files);
+    CPPUNIT_TEST (exchange);
+    CPPUNIT_TEST (compression);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -57,7 +160,226 @@ protected:
         lvtk::descriptors().pop_back(); // needed so descriptor count test doesn't fail
     }
 
+    void properties() {
+        lvtk::Descriptor<PropertyPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::URIDirectory uris;
+        const LV2_Feature* features[] = { uris.get_map_feature(), nullptr };
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+        const LV2_Feature* none[] = { nullptr };
+
+        auto h1 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto p1 = static_cast<PropertyPlug*> (h1);
+        p1->gain = 0.25f;
+        p1->count = 1234567890123;
+        p1->bypass = true;
+        p1->name = "test";
+        p1->ratio = 3.0;
+        p1->table = { 1.f, 2.f, 3.f };
+
+        lvtk::StateArchive values;
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->save (h1, lvtk::StateArchive::store_function, &values, 0, none));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 6, values.size());
+        size_t size = 0;
+        uint32_t type = 0;
+        CPPUNIT_ASSERT (values.retrieve (uris.map (LVTK_TEST_PLUGIN_URI "#table"), &size, &type) != nullptr);
+        CPPUNIT_ASSERT_EQUAL (uris.map (LV2_ATOM__Chunk), type);
+        CPPUNIT_ASSERT_EQUAL (sizeof (float) * 3, size);
+        CPPUNIT_ASSERT_EQUAL (6.0, *(const double*) values.retrieve (uris.map (LVTK_TEST_PLUGIN_URI "#ratio")));
+
+        auto h2 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto p2 = static_cast<PropertyPlug*> (h2);
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->restore (h2, lvtk::StateArchive::retrieve_function, &values, 0, none));
+        CPPUNIT_ASSERT_EQUAL (0.25f, p2->gain);
+        CPPUNIT_ASSERT_EQUAL ((int64_t) 1234567890123, p2->count);
+        CPPUNIT_ASSERT (p2->bypass);
+        CPPUNIT_ASSERT_EQUAL (std::string ("test"), p2->name);
+        CPPUNIT_ASSERT_EQUAL (3.0, p2->ratio);
+        CPPUNIT_ASSERT (p1->table == p2->table);
+
+        // wrong types are skipped, missing keys left alone
+        const int32_t wrong = 1;
+        values.store (uris.map (LVTK_TEST_PLUGIN_URI "#gain"), &wrong, sizeof (wrong), uris.map (LV2_ATOM__Int), LV2_STATE_IS_POD);
+        values.remove (uris.map (LVTK_TEST_PLUGIN_URI "#name"));
+        p2->gain = 0.5f;
+        p2->name = "kept";
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_ERR_BAD_TYPE, iface->restore (h2, lvtk::StateArchive::retrieve_function, &values, 0, none));
+        CPPUNIT_ASSERT_EQUAL (0.5f, p2->gain);
+        CPPUNIT_ASSERT_EQUAL (std::string ("kept"), p2->name);
+        CPPUNIT_ASSERT_EQUAL (3.0, p2->ratio);
+
+        desc.cleanup (h1);
+        desc.cleanup (h2);
+        lvtk::descriptors().pop_back();
+    }
+
+    void files() {
+        lvtk::Descriptor<FilePlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::URIDirectory uris;
+        const LV2_Feature* features[] = { uris.get_map_feature(), uris.get_unmap_feature(), nullptr };
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+
+        char dir[] = "/tmp/lvtk_state_XXXXXX";
+        CPPUNIT_ASSERT (mkdtemp (dir) != nullptr);
+        state_dir = dir;
+
+        LV2_State_Make_Path make_path = { this, _make_path };
+        LV2_State_Map_Path map_path = { this, _abstract_path, _absolute_path };
+        LV2_Feature make_feature = { LV2_STATE__makePath, &make_path };
+        LV2_Feature map_feature = { LV2_STATE__mapPath, &map_path };
+        const LV2_Feature* save_features[] = { &make_feature, &map_feature, nullptr };
+        const LV2_Feature* restore_features[] = { &map_feature, nullptr };
+
+        auto h1 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto p1 = static_cast<FilePlug*> (h1);
+        p1->capture.resize (1 << 16);
+        for (size_t i = 0; i < p1->capture.size(); ++i)
+            p1->capture[i] = (float) i;
+
+        // no makePath, nothing stored
+        lvtk::StateArchive values;
+        const LV2_Feature* none[] = { nullptr };
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_ERR_NO_FEATURE, iface->save (h1, lvtk::StateArchive::store_function, &values, 0, none));
+        CPPUNIT_ASSERT (values.empty());
+
+        // only the abstract path is stored
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->save (h1, lvtk::StateArchive::store_function, &values, 0, save_features));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, values.size());
+        uint32_t type = 0;
+        const auto* path = (const char*) values.retrieve (p1->key, nullptr, &type);
+        CPPUNIT_ASSERT_EQUAL (uris.map (LV2_ATOM__Path), type);
+        CPPUNIT_ASSERT_EQUAL (std::string ("capture.raw"), std::string (path));
+
+        auto h2 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto p2 = static_cast<FilePlug*> (h2);
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->restore (h2, lvtk::StateArchive::retrieve_function, &values, 0, restore_features));
+        CPPUNIT_ASSERT_EQUAL (p1->capture.size() * sizeof (float), p2->restored.size());
+        CPPUNIT_ASSERT (0 == memcmp (p1->capture.data(), p2->restored.data(), p2->restored.size()));
+
+        desc.cleanup (h1);
+        desc.cleanup (h2);
+        lvtk::descriptors().pop_back();
+
+        remove ((state_dir + "/capture.raw").c_str());
+        rmdir (dir);
+    }
+
+    void exchange() {
+        lvtk::Descriptor<ExchangePlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::URIDirectory uris;
+        const LV2_Feature* features[] = { uris.get_map_feature(), uris.get_unmap_feature(), nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<ExchangePlug*> (handle);
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+        const uint32_t key = uris.map (LVTK_TEST_PLUGIN_URI "#gain");
+
+        // nothing applied until a block boundary
+        lvtk::StateArchive values;
+        float gain = 0.5f;
+        values.store (key, &gain, sizeof (gain), 0, LV2_STATE_IS_POD);
+        const LV2_Feature* none[] = { nullptr };
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->restore (handle, lvtk::StateArchive::retrieve_function, &values, 0, none));
+        CPPUNIT_ASSERT_EQUAL (1.f, plugin->params.get()->gain);
+        desc.run (handle, 64);
+        CPPUNIT_ASSERT_EQUAL (0.5f, plugin->last);
+
+        // restore from another thread while running
+        std::atomic<bool> done { false };
+        std::thread restorer ([&]() {
+            for (int i = 1; i <= 200; ++i) {
+                lvtk::StateArchive v;
+                float g = (float) i;
+                v.store (key, &g, sizeof (g), 0, LV2_STATE_IS_POD);
+                iface->restore (handle, lvtk::StateArchive::retrieve_function, &v, 0, none);
+            }
+            done = true;
+        });
+
+        while (! done.load())
+            desc.run (handle, 64);
+        restorer.join();
+        desc.run (handle, 64);
+        plugin->params.collect();
+        desc.run (handle, 64);
+
+        CPPUNIT_ASSERT (plugin->applied.load() >= 2);
+        CPPUNIT_ASSERT_EQUAL (200.f, plugin->last);
+
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+
+    void compression() {
+        lvtk::Descriptor<CompressPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::URIDirectory uris;
+        const LV2_Feature* features[] = { uris.get_map_feature(), uris.get_unmap_feature(), nullptr };
+        auto iface = (const LV2_State_Interface*) desc.extension_data (LV2_STATE__interface);
+        const LV2_Feature* none[] = { nullptr };
+
+        auto h1 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto p1 = static_cast<CompressPlug*> (h1);
+        p1->gain = 0.75f;
+        p1->wavetable.resize (8192);
+        for (size_t i = 0; i < p1->wavetable.size(); ++i)
+            p1->wavetable[i] = (float) (i % 128) / 128.f;
+
+        lvtk::StateArchive values;
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->save (h1, lvtk::StateArchive::store_function, &values, 0, none));
+        size_t size = 0;
+        uint32_t type = 0;
+        values.retrieve (uris.map (LVTK_TEST_PLUGIN_URI "#gain"), nullptr, &type);
+        CPPUNIT_ASSERT_EQUAL (uris.map (LV2_ATOM__Float), type);
+        values.retrieve (uris.map (LVTK_TEST_PLUGIN_URI "#wavetable"), &size, &type);
+        CPPUNIT_ASSERT_EQUAL (uris.map (LVTK_STATE__Compressed), type);
+        CPPUNIT_ASSERT (size < p1->wavetable.size() * sizeof (float) / 10);
+
+        auto h2 = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto p2 = static_cast<CompressPlug*> (h2);
+        CPPUNIT_ASSERT_EQUAL (LV2_STATE_SUCCESS, iface->restore (h2, lvtk::StateArchive::retrieve_function, &values, 0, none));
+        CPPUNIT_ASSERT_EQUAL (0.75f, p2->gain);
+        CPPUNIT_ASSERT (p1->wavetable == p2->wavetable);
+
+        // a corrupt original size is rejected instead of allocated
+        const auto key = uris.map (LVTK_TEST_PLUGIN_URI "#wavetable");
+        auto stored = static_cast<const uint8_t*> (values.retrieve (key, &size, &type));
+        std::vector<uint8_t> corrupt (stored, stored + size);
+        for (int i = 4; i < 12; ++i)
+            corrupt[i] = 0xff;
+        lvtk::StateArchive bad;
+        bad.store (key, corrupt.data(), corrupt.size(), type, LV2_STATE_IS_POD);
+        iface->restore (h2, lvtk::StateArchive::retrieve_function, &bad, 0, none);
+        CPPUNIT_ASSERT (p1->wavetable == p2->wavetable);
+
+        desc.cleanup (h1);
+        desc.cleanup (h2);
+        lvtk::descriptors().pop_back();
+    }
+
 private:
+    std::string state_dir;
+
+    static char* _make_path (LV2_State_Make_Path_Handle handle, const char* path) {
+        auto self = static_cast<StateTest*> (handle);
+        return strdup ((self->state_dir + "/" + path).c_str());
+    }
+
+    static char* _abstract_path (LV2_State_Map_Path_Handle handle, const char* path) {
+        auto self = static_cast<StateTest*> (handle);
+        return strdup (path + self->state_dir.size() + 1);
+    }
+
+    static char* _absolute_path (LV2_State_Map_Path_Handle handle, const char* path) {
+        auto self = static_cast<StateTest*> (handle);
+        return strdup ((self->state_dir + "/" + path).c_str());
+    }
+
     bool store_called = false;
     bool retrieve_called = false;
     static LV2_State_Status _store (LV2_State_Handle handle,
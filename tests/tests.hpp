@@ -13,21 +13,34 @@
 
 #include <lvtk/ext/atom.hpp>
 #include <lvtk/ext/bufsize.hpp>
+#include <lvtk/ext/channel.hpp>
 #include <lvtk/ext/data_access.hpp>
 #include <lvtk/ext/instance_access.hpp>
 #include <lvtk/ext/log.hpp>
 #include <lvtk/ext/options.hpp>
 #include <lvtk/ext/resize_port.hpp>
+#include <lvtk/ext/scratch.hpp>
 #include <lvtk/ext/state.hpp>
 #include <lvtk/ext/urid.hpp>
 #include <lvtk/ext/worker.hpp>
+#include <lvtk/ext/worker_pool.hpp>
 
+#include <lvtk/binary_log.hpp>
 #include <lvtk/lvtk.hpp>
+#include <lvtk/lz4.hpp>
+#include <lvtk/mapped_file.hpp>
+#include <lvtk/metadata.hpp>
 #include <lvtk/options.hpp>
 #include <lvtk/optional.hpp>
 #include <lvtk/plugin.hpp>
+#include <lvtk/port_events.hpp>
+#include <lvtk/ring_buffer.hpp>
+#include <lvtk/state_archive.hpp>
+#include <lvtk/state_cache.hpp>
 #include <lvtk/ui.hpp>
 #include <lvtk/symbols.hpp>
+#include <lvtk/triple_buffer.hpp>
+#include <lvtk/worker.hpp>
 
 #ifndef LVTK_VOLUME_URI
     #define LVTK_VOLUME_URI "http://lvtk.org/plugins/volume"
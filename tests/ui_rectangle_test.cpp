@@ -0,0 +1,51 @@
+
+#include "tests.hpp"
+#include <sstream>
+#include <string>
+#include <lvtk/ui/rectangle.hpp>
+
+class RectangleTest : public TestFixutre {
+    using Rect = lvtk::Rectangle<int>;
+    CPPUNIT_TEST_SUITE (RectangleTest);
+    CPPUNIT_TEST (intersection);
+    CPPUNIT_TEST (united);
+    CPPUNIT_TEST (translate);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+private:
+    static Rect rect (int x, int y, int w, int h) { return { x, y, w, h }; }
+
+protected:
+    void intersection() {
+        Rect a { 0, 0, 100, 100 }, b { 50, 60, 100, 100 };
+        CPPUNIT_ASSERT (a.intersects (b));
+        CPPUNIT_ASSERT (a.intersection (b) == rect (50, 60, 50, 40));
+        CPPUNIT_ASSERT (b.intersection (a) == a.intersection (b));
+
+        Rect touching { 100, 0, 10, 10 };
+        CPPUNIT_ASSERT (! a.intersects (touching));
+        CPPUNIT_ASSERT (a.intersection (touching).empty());
+        CPPUNIT_ASSERT (! a.intersects (Rect()));
+    }
+
+    void united() {
+        Rect a { 10, 10, 10, 10 }, b { 30, 0, 5, 5 };
+        CPPUNIT_ASSERT (a.united (b) == rect (10, 0, 25, 20));
+        CPPUNIT_ASSERT (a.united (Rect()) == a);
+        CPPUNIT_ASSERT (Rect().united (b) == b);
+    }
+
+    void translate() {
+        Rect a { 10, 20, 30, 40 };
+        const lvtk::Point<int> delta { 1, 2 };
+        CPPUNIT_ASSERT ((a + delta) == rect (11, 22, 30, 40));
+        CPPUNIT_ASSERT ((a - delta) == rect (9, 18, 30, 40));
+        CPPUNIT_ASSERT (a.at (0, 0) == rect (0, 0, 30, 40));
+        CPPUNIT_ASSERT (a.at (5, 6) == rect (5, 6, 30, 40));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (RectangleTest);
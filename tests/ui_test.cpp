@@ -0,0 +1,285 @@
+
+#include "tests.hpp"
+
+struct WriteUI : lvtk::UI<WriteUI, lvtk::Idle> {
+    WriteUI (const lvtk::UIArgs& args) : UI (args) {}
+    int idle() { return 0; }
+};
+
+struct SubscribeUI : lvtk::UI<SubscribeUI, lvtk::PortSubscribe> {
+    SubscribeUI (const lvtk::UIArgs& args) : UI (args) {}
+};
+
+struct HostWrite {
+    uint32_t port;
+    uint32_t protocol;
+    std::vector<uint8_t> data;
+
+    float value() const {
+        float v = 0.f;
+        memcpy (&v, data.data(), sizeof (float));
+        return v;
+    }
+};
+
+class UITest : public TestFixutre {
+    CPPUNIT_TEST_SUITE (UITest);
+    CPPUNIT_TEST (coalesced_writes);
+    CPPUNIT_TEST (write_order);
+    CPPUNIT_TEST (port_events);
+    CPPUNIT_TEST (deferred_events);
+    CPPUNIT_TEST (queue_alignment);
+    CPPUNIT_TEST (port_subscriptions);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        writes.clear();
+    }
+
+protected:
+    void coalesced_writes() {
+        lvtk::UIArgs args;
+        args.controller = { this, _write };
+        WriteUI ui (args);
+
+        // immediate by default
+        ui.write (1, 0.5f);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, writes.size());
+
+        writes.clear();
+        ui.set_coalesced_writes (true);
+        for (int i = 0; i < 300; ++i) {
+            ui.write (1, (float) i);
+            ui.write (2, (float) -i);
+        }
+        CPPUNIT_ASSERT (writes.empty());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, ui.port_writer().pending());
+
+        // the idle interface flushes
+        lvtk::UIDescriptor<WriteUI> reg (LVTK_TEST_UI_URI);
+        const auto idle = (const LV2UI_Idle_Interface*) lvtk::ui_descriptors().back().extension_data (LV2_UI__idleInterface);
+        lvtk::ui_descriptors().pop_back();
+        CPPUNIT_ASSERT (idle != nullptr);
+        idle->idle (&ui);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, writes.size());
+        CPPUNIT_ASSERT_EQUAL (299.f, writes[0].value());
+        CPPUNIT_ASSERT_EQUAL (-299.f, writes[1].value());
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 600, ui.port_writer().writes());
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 598, ui.port_writer().saved());
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 2, ui.port_writer().flushed());
+
+        // nothing pending, nothing sent
+        idle->idle (&ui);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, writes.size());
+
+        // disabling flushes
+        ui.write (3, 1.f);
+        ui.set_coalesced_writes (false);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 3, writes.size());
+    }
+
+    void write_order() {
+        lvtk::PortWriter writer ({ this, _write });
+        const uint32_t event_type = 100;
+        const char first[] = "first", second[] = "second";
+
+        writer.write (1, 1.f);
+        writer.write (0, sizeof (first), event_type, first);
+        writer.write (1, 2.f);
+        writer.write (1, 3.f);
+        writer.write (0, sizeof (second), event_type, second);
+        writer.write (1, 4.f);
+        writer.flush();
+
+        CPPUNIT_ASSERT_EQUAL ((size_t) 5, writes.size());
+        CPPUNIT_ASSERT_EQUAL (1.f, writes[0].value());
+        CPPUNIT_ASSERT_EQUAL (std::string (first), std::string ((const char*) writes[1].data.data()));
+        CPPUNIT_ASSERT_EQUAL (event_type, writes[1].protocol);
+        CPPUNIT_ASSERT_EQUAL (3.f, writes[2].value());
+        CPPUNIT_ASSERT_EQUAL (std::string (second), std::string ((const char*) writes[3].data.data()));
+        CPPUNIT_ASSERT_EQUAL (4.f, writes[4].value());
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 1, writer.saved());
+
+        writer.write (2, 1.f);
+        writer.clear();
+        writer.flush();
+        CPPUNIT_ASSERT_EQUAL ((size_t) 5, writes.size());
+    }
+
+    void port_events() {
+        lvtk::Symbols symbols;
+        LV2UI_Port_Map port_map = { nullptr, [] (LV2UI_Feature_Handle, const char* symbol) -> uint32_t {
+                                        return strcmp (symbol, "meter") == 0 ? 7 : LV2UI_INVALID_PORT_INDEX;
+                                    } };
+        const LV2_Feature port_map_feature = { LV2_UI__portMap, &port_map };
+        lvtk::UIArgs args;
+        args.controller = { this, _write };
+        args.features.push_back (*symbols.get_map_feature());
+        args.features.push_back (port_map_feature);
+        WriteUI ui (args);
+        auto& events = ui.port_events();
+
+        float control = 0.f, peak = 0.f;
+        uint32_t atom_type = 0, other = 0;
+        events.on_control (1, [&] (float value) { control = value; });
+        events.on_atom (2, [&] (const LV2_Atom& atom) { atom_type = atom.type; });
+        events.on_event (2, [&] (uint32_t, uint32_t format, const void*) { other = format; });
+        CPPUNIT_ASSERT (events.on_peak ("meter", [&] (const LV2UI_Peak_Data& data) { peak = data.peak; }));
+        CPPUNIT_ASSERT (! events.on_peak ("unknown", [&] (const LV2UI_Peak_Data&) {}));
+
+        const float value = 0.25f;
+        ui.port_event (1, sizeof (float), 0, &value);
+        CPPUNIT_ASSERT_EQUAL (0.25f, control);
+
+        const LV2_Atom atom = { 0, symbols.map (LV2_ATOM__Int) };
+        ui.port_event (2, sizeof (atom), symbols.map (LV2_ATOM__eventTransfer), &atom);
+        CPPUNIT_ASSERT_EQUAL (symbols.map (LV2_ATOM__Int), atom_type);
+        ui.port_event (2, sizeof (value), 0, &value);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, other);
+        ui.port_event (2, sizeof (atom), 12345, &atom);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 12345, other);
+
+        // atoms whose body doesn't fit go to the event handler
+        atom_type = other = 0;
+        const LV2_Atom_Int truncated = { { 8, symbols.map (LV2_ATOM__Long) }, 1 };
+        ui.port_event (2, sizeof (truncated), symbols.map (LV2_ATOM__eventTransfer), &truncated);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, atom_type);
+        CPPUNIT_ASSERT_EQUAL (symbols.map (LV2_ATOM__eventTransfer), other);
+        const LV2_Atom_Int whole = { { sizeof (int32_t), symbols.map (LV2_ATOM__Int) }, 1 };
+        ui.port_event (2, sizeof (whole), symbols.map (LV2_ATOM__eventTransfer), &whole);
+        CPPUNIT_ASSERT_EQUAL (symbols.map (LV2_ATOM__Int), atom_type);
+
+        const LV2UI_Peak_Data data = { 0, 64, 0.75f };
+        ui.port_event (7, sizeof (data), symbols.map (LV2_UI__peakProtocol), &data);
+        CPPUNIT_ASSERT_EQUAL (0.75f, peak);
+
+        // unbound ports and formats are ignored
+        CPPUNIT_ASSERT (! events.dispatch (1, sizeof (atom), symbols.map (LV2_ATOM__eventTransfer), &atom));
+        CPPUNIT_ASSERT (! events.dispatch (100, sizeof (float), 0, &value));
+        events.remove (1);
+        CPPUNIT_ASSERT (! events.dispatch (1, sizeof (float), 0, &value));
+    }
+
+    void deferred_events() {
+        lvtk::UIDescriptor<WriteUI> reg (LVTK_TEST_UI_URI);
+        const auto desc = lvtk::ui_descriptors().back();
+        lvtk::ui_descriptors().pop_back();
+        const auto idle = (const LV2UI_Idle_Interface*) desc.extension_data (LV2_UI__idleInterface);
+
+        lvtk::UIArgs args;
+        args.controller = { this, _write };
+        WriteUI ui (args);
+        std::vector<std::pair<uint32_t, float>> applied;
+        uint32_t events = 0;
+        ui.port_events().on_control (1, [&] (float v) { applied.push_back ({ 1, v }); });
+        ui.port_events().on_control (2, [&] (float v) { applied.push_back ({ 2, v }); });
+        ui.port_events().on_event (3, [&] (uint32_t, uint32_t, const void*) {
+            ++events;
+            ui.write (1, 0.f); // writes from handlers go out after idle
+        });
+        ui.set_coalesced_writes (true);
+        ui.set_deferred_port_events (true);
+
+        const char event[] = "event";
+        for (int i = 0; i < 100; ++i) {
+            const float value = (float) i;
+            desc.port_event (&ui, 1, sizeof (float), 0, &value);
+            desc.port_event (&ui, 2, sizeof (float), 0, &value);
+        }
+        desc.port_event (&ui, 3, sizeof (event), 1, event);
+        const float last = 1000.f;
+        desc.port_event (&ui, 1, sizeof (float), 0, &last);
+        CPPUNIT_ASSERT (applied.empty());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 4, ui.deferred_port_events().size());
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 198, ui.deferred_port_events().saved());
+
+        idle->idle (&ui);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 3, applied.size());
+        CPPUNIT_ASSERT (applied[0] == std::make_pair (1u, 99.f));
+        CPPUNIT_ASSERT (applied[1] == std::make_pair (2u, 99.f));
+        CPPUNIT_ASSERT (applied[2] == std::make_pair (1u, 1000.f));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, events);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, writes.size());
+
+        // immediate again
+        ui.set_deferred_port_events (false);
+        desc.port_event (&ui, 2, sizeof (float), 0, &last);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 4, applied.size());
+    }
+
+    void queue_alignment() {
+        lvtk::PortQueue queue;
+        const LV2UI_Peak_Data peak = { 0, 1, 0.5f };
+        const LV2_Atom_Int atom = { { sizeof (int32_t), 1 }, 42 };
+        queue.push (1, sizeof (peak), 2, &peak);
+        queue.push (2, sizeof (atom), 3, &atom);
+        queue.push (3, 3, 4, "ab");
+        queue.push (4, sizeof (atom), 3, &atom);
+
+        uint32_t count = 0;
+        queue.flush ([&] (uint32_t port, uint32_t size, uint32_t, const void* data) {
+            ++count;
+            CPPUNIT_ASSERT_EQUAL ((uintptr_t) 0, (uintptr_t) data % 8);
+            if (port == 2 || port == 4)
+                CPPUNIT_ASSERT_EQUAL (42, static_cast<const LV2_Atom_Int*> (data)->body);
+        });
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 4, count);
+    }
+
+    void port_subscriptions() {
+        LV2UI_Port_Subscribe ps = { this, _subscribe, _unsubscribe };
+        const LV2_Feature feature = { LV2_UI__portSubscribe, &ps };
+        lvtk::UIArgs args;
+        args.features.push_back (feature);
+        SubscribeUI ui (args);
+        auto& subs = ui.port_subscriptions();
+
+        // two widgets showing the same port
+        subs.retain (4);
+        subs.retain (4);
+        subs.retain (4, 99);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, subscribed.size());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, subs.references (4));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, subs.size());
+
+        subs.release (4);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, subscribed.size());
+        subs.release (4);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, subscribed.size());
+        CPPUNIT_ASSERT (subscribed[0] == std::make_pair (4u, 99u));
+        subs.release (4);
+        subs.release (5);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, subs.references (4));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, subs.size());
+
+        // no feature, only counted
+        lvtk::PortSubscriptions none;
+        none.retain (1);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, none.references (1));
+    }
+
+private:
+    std::vector<HostWrite> writes;
+    std::vector<std::pair<uint32_t, uint32_t>> subscribed;
+
+    static uint32_t _subscribe (LV2UI_Feature_Handle handle, uint32_t port, uint32_t protocol, const LV2_Feature* const*) {
+        static_cast<UITest*> (handle)->subscribed.push_back ({ port, protocol });
+        return 0;
+    }
+
+    static uint32_t _unsubscribe (LV2UI_Feature_Handle handle, uint32_t port, uint32_t protocol, const LV2_Feature* const*) {
+        auto& s = static_cast<UITest*> (handle)->subscribed;
+        s.erase (std::find (s.begin(), s.end(), std::make_pair (port, protocol)));
+        return 0;
+    }
+
+    static void _write (LV2UI_Controller controller, uint32_t port, uint32_t size,
+                        uint32_t protocol, const void* data) {
+        auto self = static_cast<UITest*> (controller);
+        const auto bytes = static_cast<const uint8_t*> (data);
+        self->writes.push_back ({ port, protocol, { bytes, bytes + size } });
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (UITest);
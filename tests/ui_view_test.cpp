@@ -0,0 +1,133 @@
+
+#include "tests.hpp"
+#include <lvtk/ui/main.hpp>
+
+namespace {
+
+lvtk::Bounds bounds (int x, int y, int w, int h) { return { x, y, w, h }; }
+
+struct TestView : lvtk::View {
+    TestView (lvtk::Main& context, lvtk::Widget& widget)
+        : View (context, widget) {}
+    using View::double_buffered;
+    using View::render;
+    using View::set_double_buffered;
+};
+
+struct TestBackend : lvtk::Backend {
+    TestBackend() : Backend ("test") {}
+    std::unique_ptr<lvtk::View> create_view (lvtk::Main& context, lvtk::Widget& widget) override {
+        return std::make_unique<TestView> (context, widget);
+    }
+};
+
+/** Records filled areas in view coordinates, clipped */
+struct Recorder : lvtk::Surface {
+    struct State {
+        lvtk::Point<int> origin;
+        lvtk::Bounds clip;
+    };
+
+    State state;
+    std::vector<State> stack;
+    std::vector<lvtk::Bounds> fills;
+
+    Recorder (lvtk::Bounds area) { state.clip = area; }
+
+    void translate (const lvtk::Point<int>& pt) override {
+        state.origin = state.origin + pt;
+        state.clip = state.clip - pt;
+    }
+    void set_clip_bounds (const lvtk::Rectangle<int>& r) override { state.clip = r; }
+    lvtk::Rectangle<int> clip_bounds() const override { return state.clip; }
+    void save() override { stack.push_back (state); }
+    void restore() override {
+        state = stack.back();
+        stack.pop_back();
+    }
+    void set_fill (const lvtk::Fill&) override {}
+    void fill_rect (const lvtk::Rectangle<float>& r) override {
+        fills.push_back (r.as<int>().intersection (state.clip) + state.origin);
+    }
+};
+
+struct Block : lvtk::Widget {
+    int painted = 0;
+    void paint (lvtk::Graphics& g) override {
+        ++painted;
+        g.fill_rect (bounds().at (0, 0));
+    }
+};
+
+} // namespace
+
+class ViewTest : public TestFixutre {
+    CPPUNIT_TEST_SUITE (ViewTest);
+    CPPUNIT_TEST (render_area);
+    CPPUNIT_TEST (buffering);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void render_area() {
+        lvtk::Main main (lvtk::Mode::MODULE, std::make_unique<TestBackend>());
+        if (main.world() == 0)
+            return; // no display
+
+        Block root, a, b, c;
+        root.set_size (200, 100);
+        a.set_bounds ({ 0, 0, 50, 50 });
+        b.set_bounds ({ 100, 0, 50, 50 });
+        c.set_bounds ({ 60, 60, 20, 20 });
+        for (auto w : { &a, &b, &c }) {
+            w->set_visible (true);
+            root.add (*w);
+        }
+
+        auto view = main.create_view (root);
+        CPPUNIT_ASSERT (view != nullptr);
+        auto& tv = static_cast<TestView&> (*view);
+
+        // only widgets in the area paint, clipped to it
+        Recorder rec ({ 0, 0, 200, 100 });
+        tv.render (rec, { 90, 0, 70, 40 });
+        CPPUNIT_ASSERT_EQUAL (1, root.painted);
+        CPPUNIT_ASSERT_EQUAL (0, a.painted);
+        CPPUNIT_ASSERT_EQUAL (1, b.painted);
+        CPPUNIT_ASSERT_EQUAL (0, c.painted);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, rec.fills.size());
+        CPPUNIT_ASSERT (rec.fills[0] == bounds (90, 0, 70, 40));
+        CPPUNIT_ASSERT (rec.fills[1] == bounds (100, 0, 50, 40));
+        CPPUNIT_ASSERT (rec.stack.empty());
+
+        // an area with no children paints only the root
+        Recorder empty ({ 0, 0, 200, 100 });
+        tv.render (empty, { 160, 60, 20, 20 });
+        CPPUNIT_ASSERT_EQUAL (2, root.painted);
+        CPPUNIT_ASSERT_EQUAL (1, b.painted);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, empty.fills.size());
+
+        // an unmapped view ignores repaints
+        CPPUNIT_ASSERT (! view->visible());
+        view->repaint ({ 0, 0, 10, 10 });
+    }
+
+    void buffering() {
+        lvtk::Main main (lvtk::Mode::MODULE, std::make_unique<TestBackend>());
+        if (main.world() == 0)
+            return; // no display
+
+        lvtk::Widget root;
+        auto view = main.create_view (root);
+        auto& tv = static_cast<TestView&> (*view);
+        CPPUNIT_ASSERT (tv.double_buffered());
+        tv.set_double_buffered (false);
+        CPPUNIT_ASSERT (! tv.double_buffered());
+        tv.set_double_buffered (true);
+        CPPUNIT_ASSERT (tv.double_buffered());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ViewTest);
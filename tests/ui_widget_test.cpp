@@ -0,0 +1,260 @@
+
+#include "tests.hpp"
+#include <lvtk/ui/main.hpp>
+#include <lvtk/ui/widget.hpp>
+
+namespace {
+
+struct Leaf : lvtk::Widget {
+    bool obstructed (int, int) override { return true; }
+};
+
+struct PlainView : lvtk::View {
+    PlainView (lvtk::Main& context, lvtk::Widget& widget)
+        : View (context, widget) {}
+};
+
+struct PlainBackend : lvtk::Backend {
+    PlainBackend() : Backend ("plain") {}
+    std::unique_ptr<lvtk::View> create_view (lvtk::Main& context, lvtk::Widget& widget) override {
+        return std::make_unique<PlainView> (context, widget);
+    }
+};
+
+/** The same children in a plain and an indexed container */
+struct Scene {
+    lvtk::Widget plain, indexed;
+    std::vector<std::unique_ptr<Leaf>> a, b;
+
+    Scene (int width, int height) {
+        for (auto w : { &plain, &indexed }) {
+            w->set_visible (true);
+            w->set_size (width, height);
+        }
+        indexed.set_spatial_index (true);
+    }
+
+    size_t add (lvtk::Bounds r) {
+        for (auto list : { &a, &b }) {
+            list->push_back (std::make_unique<Leaf>());
+            list->back()->set_bounds (r);
+            list->back()->set_visible (true);
+        }
+        plain.add (*a.back());
+        indexed.add (*b.back());
+        return a.size() - 1;
+    }
+
+    void move (size_t i, lvtk::Bounds r) {
+        a[i]->set_bounds (r);
+        b[i]->set_bounds (r);
+    }
+
+    void show (size_t i, bool visible) {
+        a[i]->set_visible (visible);
+        b[i]->set_visible (visible);
+    }
+
+    void remove (size_t i) {
+        plain.remove (*a[i]);
+        indexed.remove (*b[i]);
+    }
+
+    void resize (int width, int height) {
+        plain.set_size (width, height);
+        indexed.set_size (width, height);
+    }
+
+    /** @returns the index of the child at pos, -1 for the container, -2 for none */
+    static int id (lvtk::Widget& parent, const std::vector<std::unique_ptr<Leaf>>& list, lvtk::Point<float> pos) {
+        auto w = parent.widget_at (pos);
+        if (w == nullptr)
+            return -2;
+        for (size_t i = 0; i < list.size(); ++i)
+            if (w == list[i].get())
+                return (int) i;
+        return -1;
+    }
+
+    /** @returns the number of probes which differ */
+    int compare() {
+        int differ = 0;
+        for (float y = -8.5f; y < (float) plain.height() + 8.f; y += 3.25f) {
+            for (float x = -8.5f; x < (float) plain.width() + 8.f; x += 3.25f) {
+                if (id (plain, a, { x, y }) != id (indexed, b, { x, y }))
+                    ++differ;
+                const int ix = (int) x, iy = (int) y;
+                if (plain.obstructed (ix, iy) != indexed.obstructed (ix, iy))
+                    ++differ;
+            }
+        }
+        return differ;
+    }
+};
+
+} // namespace
+
+class WidgetTest : public TestFixutre {
+    CPPUNIT_TEST_SUITE (WidgetTest);
+    CPPUNIT_TEST (spatial_index);
+    CPPUNIT_TEST (z_order);
+    CPPUNIT_TEST (rounding);
+    CPPUNIT_TEST (port_subscriptions);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+protected:
+    void spatial_index() {
+        Scene scene (400, 300);
+        CPPUNIT_ASSERT (scene.indexed.spatial_index());
+        CPPUNIT_ASSERT (! scene.plain.spatial_index());
+
+        // a grid of controls with some overlapping and out of bounds
+        for (int row = 0; row < 6; ++row)
+            for (int col = 0; col < 8; ++col)
+                scene.add ({ col * 50, row * 50, 45, 45 });
+        scene.add ({ 20, 20, 120, 90 });
+        scene.add ({ 350, 250, 100, 100 });
+        scene.add ({ -30, -30, 60, 60 });
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+
+        // move and resize
+        scene.move (3, { 200, 120, 60, 60 });
+        scene.move (10, { 10, 10, 300, 10 });
+        scene.move (12, { 500, 500, 10, 10 });
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+
+        // hide
+        scene.show (48, false);
+        scene.show (5, false);
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+        scene.show (48, true);
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+
+        // remove
+        scene.remove (0);
+        scene.remove (20);
+        scene.remove (49);
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+
+        // resize the container
+        scene.resize (600, 120);
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+        scene.move (12, { 550, 100, 40, 40 });
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+
+        // enough new children to rebuild the grid
+        for (int i = 0; i < 300; ++i)
+            scene.add ({ (i * 37) % 590, (i * 13) % 110, 8 + i % 20, 6 + i % 15 });
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+        scene.move (100, { 0, 0, 600, 120 });
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+
+        // turning it off
+        scene.indexed.set_spatial_index (false);
+        CPPUNIT_ASSERT (! scene.indexed.spatial_index());
+        CPPUNIT_ASSERT_EQUAL (0, scene.compare());
+    }
+
+    void z_order() {
+        Scene scene (100, 100);
+        const auto below = scene.add ({ 10, 10, 50, 50 });
+        const auto above = scene.add ({ 30, 30, 50, 50 });
+        CPPUNIT_ASSERT_EQUAL ((int) above, Scene::id (scene.plain, scene.a, { 40.f, 40.f }));
+        CPPUNIT_ASSERT_EQUAL ((int) above, Scene::id (scene.indexed, scene.b, { 40.f, 40.f }));
+        CPPUNIT_ASSERT_EQUAL ((int) below, Scene::id (scene.indexed, scene.b, { 20.f, 20.f }));
+
+        // moving keeps the order
+        scene.move (below, { 35, 35, 10, 10 });
+        CPPUNIT_ASSERT_EQUAL ((int) above, Scene::id (scene.indexed, scene.b, { 40.f, 40.f }));
+
+        scene.show (above, false);
+        CPPUNIT_ASSERT_EQUAL ((int) below, Scene::id (scene.plain, scene.a, { 40.f, 40.f }));
+        CPPUNIT_ASSERT_EQUAL ((int) below, Scene::id (scene.indexed, scene.b, { 40.f, 40.f }));
+    }
+
+    void rounding() {
+        Scene scene (100, 100);
+        const auto back = scene.add ({ 0, 0, 100, 100 });
+        const auto child = scene.add ({ 10, 10, 10, 10 });
+
+        // fractions belong to the pixel to their left on both paths
+        CPPUNIT_ASSERT_EQUAL ((int) back, Scene::id (scene.plain, scene.a, { 9.5f, 15.f }));
+        CPPUNIT_ASSERT_EQUAL ((int) back, Scene::id (scene.indexed, scene.b, { 9.5f, 15.f }));
+        CPPUNIT_ASSERT_EQUAL ((int) child, Scene::id (scene.plain, scene.a, { 19.5f, 15.f }));
+        CPPUNIT_ASSERT_EQUAL ((int) child, Scene::id (scene.indexed, scene.b, { 19.5f, 15.f }));
+        CPPUNIT_ASSERT_EQUAL (-2, Scene::id (scene.plain, scene.a, { -0.5f, 15.f }));
+        CPPUNIT_ASSERT_EQUAL (-2, Scene::id (scene.indexed, scene.b, { -0.5f, 15.f }));
+    }
+
+    void port_subscriptions() {
+        lvtk::PortSubscriptions subs;
+        lvtk::Main main (lvtk::Mode::MODULE, std::make_unique<PlainBackend>());
+        if (main.world() == 0)
+            return; // no display
+        main.set_port_subscriptions (&subs);
+
+        lvtk::Widget root, page, other;
+        root.set_size (100, 100);
+        for (auto w : { &root, &page, &other })
+            w->set_visible (true);
+        root.add (page);
+        page.watch_port (3);
+        other.watch_port (3);
+        other.watch_port (4);
+
+        // nothing is subscribed until shown
+        CPPUNIT_ASSERT_EQUAL ((size_t) 0, subs.size());
+        main.elevate (root, 0);
+        if (! root.showing())
+            return; // the view couldn't be shown
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (3));
+
+        // two widgets share a port
+        root.add (other);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, subs.references (3));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (4));
+
+        // hiding a widget or its parent
+        page.set_visible (false);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (3));
+        page.set_visible (true);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, subs.references (3));
+        root.set_visible (false);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 0, subs.size());
+        root.set_visible (true);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, subs.references (3));
+
+        // removing
+        root.remove (other);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (3));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, subs.references (4));
+
+        // destroying, with and without children
+        auto temp = std::make_unique<lvtk::Widget>();
+        auto child = std::make_unique<lvtk::Widget>();
+        temp->set_visible (true);
+        child->set_visible (true);
+        temp->watch_port (5);
+        child->watch_port (6);
+        temp->add (*child);
+        root.add (*temp);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (5));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (6));
+        temp.reset();
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, subs.references (5));
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, subs.references (6));
+        child.reset();
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, root.__widgets().size());
+
+        // unwatching while shown
+        page.unwatch_port (3);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 0, subs.size());
+        page.watch_port (3);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, subs.references (3));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (WidgetTest);
@@ -39,9 +39,139 @@ struct WorkerPlug : lvtk::Plugin<WorkerPlug, lvtk::Worker> {
     }
 };
 
+// plugin which echos jobs back as responses
+struct EchoPlug : lvtk::Plugin<EchoPlug, lvtk::Worker> {
+    EchoPlug (const lvtk::Args& args) : Plugin (args) {}
+
+    std::atomic<uint32_t> total_work { 0 };
+    uint32_t total_responses = 0;
+    uint32_t total_end_runs = 0;
+
+    void run (uint32_t) {
+        for (uint32_t i = 1; i <= 4; ++i)
+            schedule_work (sizeof (i), &i);
+    }
+
+    lvtk::WorkerStatus work (lvtk::WorkerRespond& respond, uint32_t size, const void* data) {
+        total_work += *(const uint32_t*) data;
+        return respond (size, data);
+    }
+
+    lvtk::WorkerStatus work_response (uint32_t size, const void* data) {
+        total_responses += *(const uint32_t*) data;
+        return LV2_WORKER_SUCCESS;
+    }
+
+    lvtk::WorkerStatus end_run() {
+        ++total_end_runs;
+        return LV2_WORKER_SUCCESS;
+    }
+};
+
+struct Job {
+    uint32_t value;
+};
+
+struct Done {
+    uint32_t value;
+    double scale;
+};
+
+// plugin using typed worker messages
+struct TypedPlug : lvtk::Plugin<TypedPlug, lvtk::Worker> {
+    TypedPlug (const lvtk::Args& args) : Plugin (args) {}
+
+    using work_messages = lvtk::WorkerMessages<Job, Done>;
+
+    uint32_t job_value = 0;
+    uint32_t done_value = 0;
+    double done_scale = 0.0;
+
+    lvtk::WorkerStatus work (lvtk::WorkerRespond& respond, const Job& job) {
+        job_value = job.value;
+        return respond (Done { job.value * 2, 0.5 });
+    }
+
+    lvtk::WorkerStatus work_response (const Done& done) {
+        done_value = done.value;
+        done_scale = done.scale;
+        return LV2_WORKER_SUCCESS;
+    }
+};
+
+struct Design {
+    lvtk::WorkerTicket ticket;
+    float cutoff;
+};
+
+struct Coeffs {
+    lvtk::WorkerTicket ticket;
+    float cutoff;
+};
+
+// plugin with a latest-wins job
+struct LatestPlug : lvtk::Plugin<LatestPlug, lvtk::Worker> {
+    LatestPlug (const lvtk::Args& args) : Plugin (args) {}
+
+    using work_messages = lvtk::WorkerMessages<Design, Coeffs>;
+
+    int num_designs = 0;
+    float applied = 0.f;
+
+    lvtk::WorkerStatus work (lvtk::WorkerRespond& respond, const Design& msg) {
+        ++num_designs;
+        return respond (Coeffs { msg.ticket, msg.cutoff });
+    }
+
+    lvtk::WorkerStatus work_response (const Coeffs& msg) {
+        applied = msg.cutoff;
+        return LV2_WORKER_SUCCESS;
+    }
+};
+
+struct Table {
+    static int live;
+    explicit Table (uint32_t n) : size (n) { ++live; }
+    ~Table() { --live; }
+    uint32_t size;
+};
+int Table::live = 0;
+
+struct LoadTable {
+    uint32_t size;
+};
+
+struct TableLoaded {
+    Table* table;
+};
+
+// plugin which builds objects on the worker and swaps them in
+struct HandoffPlug : lvtk::Plugin<HandoffPlug, lvtk::Worker> {
+    HandoffPlug (const lvtk::Args& args) : Plugin (args) {}
+
+    using work_messages = lvtk::WorkerMessages<LoadTable, TableLoaded>;
+
+    lvtk::Handoff<Table> table;
+
+    lvtk::WorkerStatus work (lvtk::WorkerRespond& respond, const LoadTable& msg) {
+        return respond (TableLoaded { new Table (msg.size) });
+    }
+
+    lvtk::WorkerStatus work_response (const TableLoaded& msg) {
+        return retire (table.swap (msg.table));
+    }
+};
+
 class Worker : public TestFixutre {
     CPPUNIT_TEST_SUITE (Worker);
     CPPUNIT_TEST (integration);
+    CPPUNIT_TEST (threaded);
+    CPPUNIT_TEST (typed);
+    CPPUNIT_TEST (pool);
+    CPPUNIT_TEST (pool_exceptions);
+    CPPUNIT_TEST (latest);
+    CPPUNIT_TEST (latest_full_queue);
+    CPPUNIT_TEST (handoff);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -89,6 +219,328 @@ protected:
         lvtk::descriptors().pop_back(); // needed so descriptor count test doesn't fail
     }
 
+    void threaded() {
+        lvtk::Descriptor<EchoPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::WorkerThread worker;
+        const LV2_Feature* features[] = { worker.get_schedule_feature(), nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        CPPUNIT_ASSERT (handle != nullptr);
+        CPPUNIT_ASSERT (worker.start (&desc, handle));
+        CPPUNIT_ASSERT (worker.running());
+
+        auto plugin = static_cast<EchoPlug*> (handle);
+        desc.run (handle, 64);
+        for (int i = 0; i < 1000 && plugin->total_responses < 10; ++i) {
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+            worker.emit_responses();
+        }
+
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 10, plugin->total_work.load());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 10, plugin->total_responses);
+        CPPUNIT_ASSERT (plugin->total_end_runs > 0);
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, worker.dropped_requests());
+
+        worker.stop();
+        CPPUNIT_ASSERT (! worker.running());
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+
+    void typed() {
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 0, TypedPlug::work_messages::tag<Job>());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 1, TypedPlug::work_messages::tag<Done>());
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 2, TypedPlug::work_messages::tag<int>());
+
+        lvtk::Descriptor<TypedPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        lvtk::WorkerThread worker;
+        const LV2_Feature* features[] = { worker.get_schedule_feature(), nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<TypedPlug*> (handle);
+        CPPUNIT_ASSERT (worker.start (&desc, handle));
+
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_SUCCESS, plugin->schedule (Job { 21 }));
+        for (int i = 0; i < 1000 && plugin->done_value == 0; ++i) {
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+            worker.emit_responses();
+        }
+
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 21, plugin->job_value);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 42, plugin->done_value);
+        CPPUNIT_ASSERT_EQUAL (0.5, plugin->done_scale);
+
+        // no typed work handler for Done, and bad sizes are rejected
+        auto iface = (const LV2_Worker_Interface*) desc.extension_data (LV2_WORKER__interface);
+        lvtk::WorkerPacket<Done> packet { 1, { 1, 1.0 } };
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_ERR_UNKNOWN, iface->work (handle, nullptr, nullptr, sizeof (packet), &packet));
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_ERR_UNKNOWN, iface->work_response (handle, sizeof (uint32_t), &packet));
+
+        worker.stop();
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+
+    void pool() {
+        lvtk::WorkerPool pool (4);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 4, pool.size());
+
+        std::vector<uint32_t> order;
+        pool.run (
+            64, [] (uint32_t i) {
+                // finish in roughly reverse order
+                std::this_thread::sleep_for (std::chrono::microseconds (64 - i));
+                return i * i;
+            },
+            [&] (uint32_t i, uint32_t& result) {
+                CPPUNIT_ASSERT_EQUAL (i * i, result);
+                order.push_back (i);
+            });
+
+        CPPUNIT_ASSERT_EQUAL ((size_t) 64, order.size());
+        for (uint32_t i = 0; i < 64; ++i)
+            CPPUNIT_ASSERT_EQUAL (i, order[i]);
+
+        // typed responses go out in submission order
+        std::vector<uint32_t> responses;
+        auto respond_function = [] (LV2_Worker_Respond_Handle handle, uint32_t size, const void* data) {
+            auto packet = static_cast<const lvtk::WorkerPacket<Done>*> (data);
+            static_cast<std::vector<uint32_t>*> (handle)->push_back (packet->body.value);
+            return LV2_WORKER_SUCCESS;
+        };
+        lvtk::WorkerRespond respond (nullptr, respond_function, &responses, &TypedPlug::work_messages::keys());
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_SUCCESS, pool.run (respond, 16, [] (uint32_t i) { return Done { i, 1.0 }; }));
+        CPPUNIT_ASSERT_EQUAL ((size_t) 16, responses.size());
+        for (uint32_t i = 0; i < 16; ++i)
+            CPPUNIT_ASSERT_EQUAL (i, responses[i]);
+    }
+
+    void pool_exceptions() {
+        lvtk::WorkerPool pool (3);
+
+        // a failing job stops delivery, the rest still finish first
+        std::vector<uint32_t> order;
+        std::atomic<uint32_t> finished { 0 };
+        bool thrown = false;
+        try {
+            pool.run (
+                32, [&] (uint32_t i) {
+                    std::this_thread::sleep_for (std::chrono::microseconds (32 - i));
+                    ++finished;
+                    if (i == 5)
+                        throw std::runtime_error ("job");
+                    return i;
+                },
+                [&] (uint32_t i, uint32_t&) { order.push_back (i); });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CPPUNIT_ASSERT (thrown);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 32, finished.load());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 5, order.size());
+        for (uint32_t i = 0; i < 5; ++i)
+            CPPUNIT_ASSERT_EQUAL (i, order[i]);
+
+        // so does a failing delivery
+        finished = 0;
+        order.clear();
+        thrown = false;
+        try {
+            pool.run (
+                32, [&] (uint32_t i) { ++finished; return i; },
+                [&] (uint32_t i, uint32_t&) {
+                    if (i == 2)
+                        throw std::logic_error ("deliver");
+                    order.push_back (i);
+                });
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        CPPUNIT_ASSERT (thrown);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 32, finished.load());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 2, order.size());
+
+        // and the pool is still usable
+        uint32_t sum = 0;
+        pool.run (
+            10, [] (uint32_t i) { return i; },
+            [&] (uint32_t, uint32_t& result) { sum += result; });
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 45, sum);
+    }
+
+    void latest() {
+        lvtk::Descriptor<LatestPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        // queue requests and responses here instead of on a thread
+        using Queue = std::vector<std::vector<uint8_t>>;
+        Queue requests, responses;
+        auto push = [] (void* handle, uint32_t size, const void* data) {
+            auto bytes = static_cast<const uint8_t*> (data);
+            static_cast<Queue*> (handle)->emplace_back (bytes, bytes + size);
+            return LV2_WORKER_SUCCESS;
+        };
+
+        LV2_Worker_Schedule schedule = { &requests, push };
+        LV2_Feature feature = { LV2_WORKER__schedule, &schedule };
+        const LV2_Feature* features[] = { &feature, nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<LatestPlug*> (handle);
+        auto iface = (const LV2_Worker_Interface*) desc.extension_data (LV2_WORKER__interface);
+
+        for (float cutoff : { 100.f, 200.f, 300.f })
+            plugin->schedule_latest (0, Design { {}, cutoff });
+        CPPUNIT_ASSERT_EQUAL ((size_t) 3, requests.size());
+
+        for (auto& r : requests)
+            iface->work (handle, push, &responses, (uint32_t) r.size(), r.data());
+        CPPUNIT_ASSERT_EQUAL (1, plugin->num_designs);
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 2, plugin->coalesced_jobs());
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, responses.size());
+
+        // a newer request makes the pending response stale
+        plugin->schedule_latest (0, Design { {}, 400.f });
+        iface->work_response (handle, (uint32_t) responses[0].size(), responses[0].data());
+        CPPUNIT_ASSERT_EQUAL (0.f, plugin->applied);
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 1, plugin->dropped_responses());
+
+        // a different key is unaffected
+        requests.clear();
+        responses.clear();
+        plugin->schedule_latest (1, Design { {}, 500.f });
+        iface->work (handle, push, &responses, (uint32_t) requests[0].size(), requests[0].data());
+        iface->work_response (handle, (uint32_t) responses[0].size(), responses[0].data());
+        CPPUNIT_ASSERT_EQUAL (500.f, plugin->applied);
+
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+
+    void latest_full_queue() {
+        lvtk::Descriptor<LatestPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        struct Queue {
+            std::vector<std::vector<uint8_t>> items;
+            bool full = false;
+        } requests, responses;
+        auto push = [] (void* handle, uint32_t size, const void* data) {
+            auto queue = static_cast<Queue*> (handle);
+            if (queue->full)
+                return LV2_WORKER_ERR_NO_SPACE;
+            auto bytes = static_cast<const uint8_t*> (data);
+            queue->items.emplace_back (bytes, bytes + size);
+            return LV2_WORKER_SUCCESS;
+        };
+
+        LV2_Worker_Schedule schedule = { &requests, push };
+        LV2_Feature feature = { LV2_WORKER__schedule, &schedule };
+        const LV2_Feature* features[] = { &feature, nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<LatestPlug*> (handle);
+        auto iface = (const LV2_Worker_Interface*) desc.extension_data (LV2_WORKER__interface);
+
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_SUCCESS, plugin->schedule_latest (0, Design { {}, 100.f }));
+
+        // the host's queue fills up, the queued request must still run
+        requests.full = true;
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_ERR_NO_SPACE, plugin->schedule_latest (0, Design { {}, 200.f }));
+        requests.full = false;
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, requests.items.size());
+
+        auto& r = requests.items[0];
+        iface->work (handle, push, &responses, (uint32_t) r.size(), r.data());
+        CPPUNIT_ASSERT_EQUAL (1, plugin->num_designs);
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, plugin->coalesced_jobs());
+        iface->work_response (handle, (uint32_t) responses.items[0].size(), responses.items[0].data());
+        CPPUNIT_ASSERT_EQUAL (100.f, plugin->applied);
+
+        // a request which runs before schedule_latest returns isn't stale
+        auto inline_work = [] (void* handle, uint32_t size, const void* data) {
+            auto self = static_cast<LatestPlug*> (handle);
+            const auto& packet = *static_cast<const lvtk::WorkerPacket<Design>*> (data);
+            return self->is_latest (packet.body.ticket) ? LV2_WORKER_SUCCESS
+                                                        : LV2_WORKER_ERR_UNKNOWN;
+        };
+        schedule.handle = handle;
+        schedule.schedule_work = inline_work;
+        CPPUNIT_ASSERT_EQUAL (LV2_WORKER_SUCCESS, plugin->schedule_latest (0, Design { {}, 300.f }));
+
+        desc.cleanup (handle);
+        lvtk::descriptors().pop_back();
+    }
+
+    void handoff() {
+        lvtk::Descriptor<HandoffPlug> reg (LVTK_TEST_PLUGIN_URI);
+        const auto& desc = lvtk::descriptors().back();
+
+        struct Queue {
+            std::vector<std::vector<uint8_t>> items;
+            bool full = false;
+        } requests, responses;
+        auto push = [] (void* handle, uint32_t size, const void* data) {
+            auto queue = static_cast<Queue*> (handle);
+            if (queue->full)
+                return LV2_WORKER_ERR_NO_SPACE;
+            auto bytes = static_cast<const uint8_t*> (data);
+            queue->items.emplace_back (bytes, bytes + size);
+            return LV2_WORKER_SUCCESS;
+        };
+        auto work_all = [&] (LV2_Handle handle, const LV2_Worker_Interface* iface) {
+            for (auto& r : requests.items)
+                iface->work (handle, push, &responses, (uint32_t) r.size(), r.data());
+            requests.items.clear();
+            for (auto& r : responses.items)
+                iface->work_response (handle, (uint32_t) r.size(), r.data());
+            responses.items.clear();
+        };
+
+        LV2_Worker_Schedule schedule = { &requests, push };
+        LV2_Feature feature = { LV2_WORKER__schedule, &schedule };
+        const LV2_Feature* features[] = { &feature, nullptr };
+        auto handle = desc.instantiate (&desc, 44100.0, "/fake/path", features);
+        auto plugin = static_cast<HandoffPlug*> (handle);
+        auto iface = (const LV2_Worker_Interface*) desc.extension_data (LV2_WORKER__interface);
+
+        // first object, nothing to retire
+        plugin->schedule (LoadTable { 16 });
+        work_all (handle, iface);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 16, plugin->table->size);
+        CPPUNIT_ASSERT_EQUAL (1, Table::live);
+        CPPUNIT_ASSERT (requests.items.empty());
+
+        // the replaced object goes back to the worker to be deleted
+        plugin->schedule (LoadTable { 32 });
+        work_all (handle, iface);
+        CPPUNIT_ASSERT_EQUAL ((uint32_t) 32, plugin->table->size);
+        CPPUNIT_ASSERT_EQUAL (2, Table::live);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, requests.items.size());
+        work_all (handle, iface);
+        CPPUNIT_ASSERT_EQUAL (1, Table::live);
+
+        // held while the queue is full, sent again from end_run
+        plugin->schedule (LoadTable { 64 });
+        iface->work (handle, push, &responses, (uint32_t) requests.items[0].size(), requests.items[0].data());
+        requests.items.clear();
+        requests.full = true;
+        iface->work_response (handle, (uint32_t) responses.items[0].size(), responses.items[0].data());
+        responses.items.clear();
+        CPPUNIT_ASSERT_EQUAL (2, Table::live);
+        CPPUNIT_ASSERT (requests.items.empty());
+        requests.full = false;
+        iface->end_run (handle);
+        CPPUNIT_ASSERT_EQUAL ((size_t) 1, requests.items.size());
+        work_all (handle, iface);
+        CPPUNIT_ASSERT_EQUAL (1, Table::live);
+        CPPUNIT_ASSERT_EQUAL ((uint64_t) 0, plugin->leaked_objects());
+
+        desc.cleanup (handle);
+        CPPUNIT_ASSERT_EQUAL (0, Table::live);
+        lvtk::descriptors().pop_back();
+    }
+
 private:
     bool work_was_requested = false;
     uint32_t work_data = 0, work_size = 0;